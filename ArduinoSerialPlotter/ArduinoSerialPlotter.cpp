@@ -1,19 +1,40 @@
 ﻿// ArduinoSerialPlotter.cpp : Defines the entry point for the application.
 //
+#ifdef _MSC_VER
 #pragma comment(linker, "/SUBSYSTEM:windows /ENTRY:mainCRTStartup")
+#endif
 
 #include "ArduinoSerialPlotter.h"
+#include "padded_buffer.h"
 #include "real_vector.h"
+#include "sample_columns.h"
 
 #include "SerialClass.h" // Library described above
+#include "data_source.h"
+#include "json_framer.h"
+#include "line_protocol.h"
+#include "plotter_binary.h"
+#include "port_list.h"
+#include "read_scheduler.h"
+#include "serial_reader.h"
+#include "utf8_repair.h"
+#include "tx_queue.h"
+#include <array>
 #include <charconv>
 #include <fmt/core.h>
 #include <fmt/format.h>
 #include <math.h>
+#include <mutex>
 #include <ostream>
 #include <stdio.h>
 #include <string>
+#ifdef _WIN32
 #include <tchar.h>
+#else
+#include <malloc.h>
+#define _msize malloc_usable_size
+#endif
+#include <thread>
 #include <unordered_map>
 
 #include "simdjson.h"
@@ -381,8 +402,12 @@ template <typename... Args> void format_out(Args &&...args) {
     // cout_buffer.clear();
 }
 
+// samples a graph keeps until a message says otherwise
+constexpr size_t default_limit = 60;
+
 struct graph_t {
-    real::vector<real::vector<struct nk_vec2>> values;
+    // the newest limit rows of timestamps and values
+    sample_columns samples{default_limit};
     // x (evens), y (odds)
     real::vector<float> points;
     real::vector<std::string> labels;
@@ -391,11 +416,127 @@ struct graph_t {
     smooth_data<float> upper_value;
     smooth_data<float> lower_value;
 
-    size_t limit = 60;
+    size_t limit = default_limit;
     size_t slots = 0;
     std::string title;
+    // fingerprint of the raw t/l/c/pd text the fields above were last decoded from, 0 when they need decoding
+    size_t schema = 0;
+    // int16 samples from the binary protocol are multiplied by this
+    float scale = 1.0f;
 };
 
+// what a device is sending, handle_json follows it from one to another
+enum class stream_format { json, binary, lines };
+
+// a text line longer than this is taken for something else
+constexpr size_t max_line_bytes = 1 << 12;
+
+// everything one data stream keeps between handle_json calls
+// each connected device owns one, so devices never share buffers, parser state or graphs
+struct stream_t {
+    ondemand::parser parser;
+    // incoming bytes land here, producers write into the tail and handle_json parses in place
+    real::padded_buffer buffer{4096};
+    // finds where objects in buffer start and end, always consume() so it stays in step
+    json_framer framer;
+    // the complete objects found by the last handle_json call
+    real::vector<json_framer::frame> frames;
+    real::vector<graph_t> graphs;
+    // color for slots that don't name one
+    nk_color default_color = {175, 175, 175, 255};
+    // complete objects handed to the decoder
+    size_t objects_parsed = 0;
+    // bytes thrown away without being decoded, whitespace between objects doesn't count
+    size_t dropped_bytes = 0;
+    // times the parser gave up on what it was looking at and skipped ahead to find the next object
+    size_t resyncs = 0;
+    // complete objects discarded because they were malformed or missing fields
+    size_t truncated_objects = 0;
+    // bytes that weren't valid utf-8 (replaced with '?'), and how many separate runs of them there were
+    size_t invalid_utf8_bytes = 0;
+    size_t invalid_utf8_regions = 0;
+    // everything in buffer before this has been checked for valid utf-8
+    size_t validated = 0;
+    // json objects, binary packets (plotter_binary.h, latched by the first intact one) or text lines
+    // (line_protocol.h, picked when what isn't json reads as lines of numbers)
+    stream_format format = stream_format::json;
+    // graphs the binary packets have talked about since the stream switched to them
+    size_t binary_graphs = 0;
+    // scratch to undo the cobs encoding into
+    uint8_t packet[plotter_binary_max_frame];
+    // the line ends found by the last handle_lines call, everything before lines_scanned has been searched
+    real::vector<size_t> line_ends;
+    size_t lines_scanned = 0;
+    // text lines plotted so far, they have no timestamp so this is their x
+    size_t line_samples = 0;
+    // bytes of samples each graph keeps in ram, older rows are spilled to disk (spill_store.h), 0 keeps them all in ram
+    size_t ram_budget = 0;
+
+    void consume(size_t count) noexcept {
+        buffer.consume(count);
+        framer.consumed(count);
+        validated = validated > count ? validated - count : 0;
+        lines_scanned = lines_scanned > count ? lines_scanned - count : 0;
+    }
+    // drop count bytes that couldn't be parsed from the front of buffer
+    void resync(size_t count) noexcept;
+    // checks the bytes that arrived since the last call up to size, a code point cut off by the end of a read waits
+    // for the rest
+    void validate_utf8(size_t size) noexcept;
+    // where the first intact binary packet among the bytes that arrived since the last call starts, npos if there
+    // is none, json never contains the 0x00 that ends a packet so this is cheap to do on every call
+    size_t find_binary() noexcept;
+};
+
+// number of bytes in [first, last) that aren't json whitespace
+size_t count_garbage(const char *first, const char *last) noexcept {
+    size_t count = 0;
+    for (; first != last; first++)
+        count += !(*first == ' ' || *first == '\n' || *first == '\r' || *first == '\t');
+    return count;
+}
+
+void stream_t::resync(size_t count) noexcept {
+    const size_t garbage = count_garbage(buffer.data(), buffer.data() + count);
+    dropped_bytes += garbage;
+    resyncs += garbage != 0;
+    consume(count);
+}
+
+void stream_t::validate_utf8(size_t size) noexcept {
+    const size_t end = utf8_complete_prefix(buffer.data(), size);
+    if (end <= validated)
+        return;
+    // the fast check nearly always passes, only a failure pays for finding out where
+    if (!simdjson::validate_utf8(buffer.data() + validated, end - validated))
+        invalid_utf8_bytes += utf8_repair(buffer.data() + validated, end - validated, invalid_utf8_regions);
+    validated = end;
+}
+
+size_t stream_t::find_binary() noexcept {
+    // only what hasn't been through validate_utf8 is still exactly as it arrived
+    const uint8_t *data = (const uint8_t *)buffer.data();
+    const size_t size = buffer.size();
+    size_t begin = validated;
+    for (size_t i = validated; i < size;) {
+        const uint8_t *zero = (const uint8_t *)std::memchr(data + i, 0, size - i);
+        if (!zero)
+            break;
+        const size_t end = zero - data;
+        // the first packet may have started before what we can see, the crc catches that
+        if (end > begin && end - begin < plotter_binary_max_frame) {
+            const size_t length = plotter_binary_unframe(data + begin, end - begin, packet);
+            if (plotter_binary_check(packet, length) && packet[0] >= plotter_binary_schema &&
+                packet[0] <= plotter_binary_int16_samples)
+                return begin;
+        }
+        begin = end + 1;
+        i = end + 1;
+    }
+    return json_framer::npos;
+}
+
+
 size_t get_lsb_set(unsigned int v) noexcept {
     // find the number of trailing zeros in 32-bit v
     int r; // result goes here
@@ -666,11 +807,11 @@ nk_flags nk_chart_draw_line_uv(struct nk_context *ctx, struct nk_rect chart_boun
     return 0;
 }
 
-nk_flags nk_chart_draw_value_uv(struct nk_context *ctx, struct nk_rect chart_bounds, float min_value, float max_value,
-                                float uv, float line_length, float line_thickness, nk_color color, nk_flags alignment,
-                                nk_flags text_alignment) {
-    float range = max_value - min_value;
-    float value = min_value + (uv * range);
+nk_flags nk_chart_draw_value_uv(struct nk_context *ctx, struct nk_rect chart_bounds, double min_value,
+                                double max_value, float uv, float line_length, float line_thickness, nk_color color,
+                                nk_flags alignment, nk_flags text_alignment) {
+    double range = max_value - min_value;
+    double value = min_value + (uv * range);
     char text_value[64];
     auto chrs = std::to_chars(text_value, text_value + 64, value);
     *chrs.ptr = 0;
@@ -736,243 +877,703 @@ nk_flags nk_chart_draw_value_uv(struct nk_context *ctx, struct nk_rect chart_bou
     return 0;
 }
 
-std::string stream_buffer;
-// returns the number of graphs to draw, 0 -> no data / no change
-size_t handle_json(ondemand::parser &parser, struct nk_context *ctx, real::vector<graph_t> &graphs, const char *ptr,
-                   uint32_t read_count) {
-    size_t graphs_to_display = 0;
-    if (read_count) {
-        // make room for simdjson's scratchbuffer and the incoming data
-        if (stream_buffer.capacity() < (stream_buffer.size() + read_count + (SIMDJSON_PADDING + 1)))
-            stream_buffer.reserve((stream_buffer.size() + read_count) * 2 + (SIMDJSON_PADDING + 1));
-        // append the data in case we had incomplete data before.
-        stream_buffer.append(ptr, read_count);
-        // wait for buffer to be a decent size
-        if (stream_buffer.size() < 512)
-            return graphs_to_display;
-        // validate buffer is utf8 once
-        if (!simdjson::validate_utf8(stream_buffer.data(), stream_buffer.size()))
-            return graphs_to_display;
+// the keys a graph object can carry, anything else is skipped
+enum class graph_key : uint8_t { other, title, xvy, limit, size, labels, colors, data };
 
-        ondemand::document graph_data;
-        do {
-            auto lbrace = std::find(stream_buffer.data(), stream_buffer.data() + stream_buffer.size(), '{');
+struct graph_key_name {
+    std::string_view name;
+    graph_key key = graph_key::other;
+};
 
-            size_t dist = lbrace - stream_buffer.data();
+constexpr graph_key_name graph_key_names[] = {{"t", graph_key::title},  {"xvy", graph_key::xvy},
+                                              {"pd", graph_key::limit}, {"sz", graph_key::size},
+                                              {"l", graph_key::labels}, {"c", graph_key::colors},
+                                              {"d", graph_key::data}};
+
+// every protocol key starts with a different letter, the low 5 bits of it are enough to tell them apart
+constexpr size_t graph_key_slot(char first) { return (uint8_t)first & 31; }
+
+constexpr std::array<graph_key_name, 32> graph_key_table = [] {
+    std::array<graph_key_name, 32> table{};
+    for (const graph_key_name &entry : graph_key_names)
+        table[graph_key_slot(entry.name[0])] = entry;
+    return table;
+}();
+
+static_assert(
+    [] {
+        for (const graph_key_name &entry : graph_key_names)
+            if (graph_key_table[graph_key_slot(entry.name[0])].key != entry.key)
+                return false;
+        return true;
+    }(),
+    "two graph keys share a slot in graph_key_table");
+
+// one table lookup and one compare against the raw key text, no unescaping
+inline graph_key classify_graph_key(ondemand::raw_json_string key) noexcept {
+    const graph_key_name &entry = graph_key_table[graph_key_slot(*key.raw())];
+    return entry.key != graph_key::other && key.unsafe_is_equal(entry.name) ? entry.key : graph_key::other;
+}
 
-            padded_string_view json(stream_buffer.data() + dist, stream_buffer.size() - dist,
-                                    stream_buffer.capacity() - dist);
-            auto error = parser.iterate(json).get(graph_data);
-            size_t g = 0;
-            if (!error) {
-#if 1
-                // bool result = true;
-                std::string_view v;
-                try {
-                    // get the view of the json object
-                    // this effectively validates that we have a complete json object (no errors) in our buffer
-                    // seems like additional effort
-                    
-                    auto error = simdjson::to_json_string(graph_data).get(v);
-                    if (error == simdjson::INCOMPLETE_ARRAY_OR_OBJECT) {
-                        // wait for object to complete in a another call
-                        return graphs_to_display;
-                    } else if (error != simdjson::SUCCESS) {
-                        // general failure move buffer over by one
-                        stream_buffer.erase(stream_buffer.begin());
-                        return graphs_to_display;
-                    }
-                    
-                    // now we extract the data we need
-                    /*
-                    ondemand::object obj;
-                    auto objerr = graph_data.get_object().get(obj);
-                    if (objerr == simdjson::INCOMPLETE_ARRAY_OR_OBJECT) {
-                        //nothing to parse here
-                        return graphs_to_display;
-                    } else if (objerr != simdjson::SUCCESS) {
-                        stream_buffer.erase(stream_buffer.begin());
-                        return graphs_to_display;
-                    } else {
-                        //ok?
-                        v = {stream_buffer.data()+dist, 1}; //stream_buffer.capacity()-dist
-                    }
-                    */
-                    
-                    /*
-                    ondemand::json_type t;
-                    auto error = graph_data.type().get(t);
-                    if (error == simdjson::INCOMPLETE_ARRAY_OR_OBJECT) {
-                        // wait for object to complete in a another call
-                        return graphs_to_display;
-                    } else if (error != simdjson::SUCCESS) {
-                        stream_buffer.erase(stream_buffer.begin());
-                        return graphs_to_display;
-                    }
+// folds the raw text of one layout field (title, labels, colors, limit) into a graph's fingerprint
+inline size_t schema_mix(size_t h, graph_key key, std::string_view raw) noexcept {
+    h = (h ^ (size_t)key) * 0x100000001b3;
+    return (h ^ std::hash<std::string_view>{}(raw)) * 0x100000001b3;
+}
 
-                    if (t != ondemand::json_type::object) {
-                        stream_buffer.erase(stream_buffer.begin());
-                        return graphs_to_display;
-                    }
-                    */
-                    // size_t ts;
-                    // auto err = graph_data.get_object().find_field("t").get(ts);
-                    size_t ts;
-                    auto err = graph_data["t"].get_uint64().get(ts);
-                    if (err) {
-                        // could not find timestamp field
-                        // erase the object we read from the stream
-                        stream_buffer.erase(size_t{0}, (v.data() + v.size()) - stream_buffer.data());
-                        continue;
-                    } else {
-                        ondemand::array graphs_array;
-                        auto graphs_err = graph_data["g"].get_array().get(graphs_array);
-
-                        if (graphs_err) {
-                            // could not find the g field (graphs)
-                            // erase the object we read from the stream
-                            stream_buffer.erase(size_t{0}, (v.data() + v.size()) - stream_buffer.data());
-                            continue; // return graphs_to_display;
-                        } else {
-                            for (auto graph : graphs_array) {
-                                // add graph to keep track of
-                                if (g >= graphs.size()) {
-                                    graphs.emplace_back();
-                                    // graphs[g].values.reserve(128);
-                                };
-                                std::string_view title;
-                                if (auto title_err = graph["t"].get_string().get(title)) {
+// makes sure graph has a slot at index
+inline void add_slot(stream_t &stream, graph_t &graph, size_t index) {
+    graph.samples.set_ram_budget(stream.ram_budget);
+    while (index >= graph.samples.slots()) {
+        graph.samples.add_slot();
+        graph.labels.emplace_back("");
+        graph.colors.emplace_back(stream.default_color);
+    }
+}
 
-                                } else {
-                                    graphs[g].title = title;
-                                }
+// how many samples each slot keeps, the newest ones survive a smaller limit
+inline void set_limit(stream_t &stream, graph_t &graph, size_t limit) {
+    // clamp to at least 1 data point
+    graph.limit = limit > 0 ? limit : 1;
+    // before the capacity, a long history shouldn't be allocated in ram on the way to being spilled
+    graph.samples.set_ram_budget(stream.ram_budget);
+    graph.samples.set_capacity(graph.limit);
+}
 
-                                ondemand::array labels_array;
-                                if (auto labels_err = graph["l"].get_array().get(labels_array)) {
+// how many bytes of samples each of the stream's graphs keeps in ram from now on, 0 keeps them all in ram
+inline void set_ram_budget(stream_t &stream, size_t bytes) {
+    if (bytes == stream.ram_budget)
+        return;
+    stream.ram_budget = bytes;
+    for (size_t i = 0; i < stream.graphs.size(); i++)
+        stream.graphs[i].samples.set_ram_budget(bytes);
+}
 
-                                } else {
-                                    size_t count = 0;
-                                    for (auto label : labels_array) {
-                                        if (count >= graphs[g].values.size()) {
-                                            graphs[g].values.emplace_back();
-                                            graphs[g].values[count].reserve(graphs[g].limit);
-                                            graphs[g].labels.emplace_back("");
-                                            graphs[g].colors.emplace_back(ctx->style.chart.color);
-                                        }
+// decodes the title, labels, colors and limit into graph, only needed when its fingerprint changed
+inline void decode_layout(stream_t &stream, graph_t &graph, ondemand::object &fields) {
+    // how many slots got an explicit color, those keep it even if the labels come later
+    size_t colored = 0;
+    for (auto field : fields) {
+        switch (classify_graph_key(field.key().value())) {
+        case graph_key::title: {
+            std::string_view title;
+            if (!field.value().get_string().get(title))
+                graph.title = title;
+            break;
+        }
+        case graph_key::labels: {
+            ondemand::array labels_array;
+            if (field.value().get_array().get(labels_array))
+                break;
+            size_t count = 0;
+            for (auto label : labels_array) {
+                add_slot(stream, graph, count);
+                std::string_view name = label.get_string().value();
+                graph.labels[count] = name;
+                if (count >= colored)
+                    graph.colors[count] = get_color(name);
+                count++;
+            }
+            break;
+        }
+        case graph_key::colors: {
+            // if we have a color for the index it overrides the hashed one
+            ondemand::array colors_array;
+            if (field.value().get_array().get(colors_array))
+                break;
+            size_t count = 0;
+            for (auto color : colors_array) {
+                add_slot(stream, graph, count);
+                graph.colors[count] = get_color(color.get_string().value());
+                count++;
+            }
+            colored = count;
+            break;
+        }
+        case graph_key::limit: {
+            size_t limit = default_limit;
+            if (!field.value().get(limit))
+                set_limit(stream, graph, limit);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
 
-                                        auto v = label.get_string();
-                                        auto vw = v.value();
-                                        graphs[g].labels[count] = vw;
-                                        graphs[g].colors[count] = get_color(vw);
+// what decode_object made of a message
+enum class decode_status { ok, no_timestamp, no_graphs, no_data, malformed };
 
-                                        count++;
-                                    }
-                                }
-                                // if we have a color for the index it overrides the hashed one
-                                ondemand::array colors_array;
-                                if (auto color_err = graph["c"].get_array().get(colors_array)) {
+// decodes one plotter message into stream.graphs, g ends up as the number of graphs it carried
+template <typename document_type> decode_status decode_object(stream_t &stream, document_type &graph_data, size_t &g) {
+    real::vector<graph_t> &graphs = stream.graphs;
+    g = 0;
 
-                                } else {
-                                    size_t count = 0;
-                                    for (auto color : colors_array) {
-                                        if (count >= graphs[g].values.size()) {
-                                            graphs[g].values.emplace_back();
-                                            graphs[g].values[count].reserve(graphs[g].limit);
-                                            graphs[g].labels.emplace_back("");
-                                            graphs[g].colors.emplace_back(ctx->style.chart.color);
-                                        }
+    size_t ts;
+    auto err = graph_data["t"].get_uint64().get(ts);
+    if (err) {
+        // could not find timestamp field
+        return decode_status::no_timestamp;
+    }
+    ondemand::array graphs_array;
+    auto graphs_err = graph_data["g"].get_array().get(graphs_array);
+    if (graphs_err) {
+        // could not find the g field (graphs)
+        return decode_status::no_graphs;
+    }
+    const double timestamp = (double)ts;
+    // graphs that had a row of data, one without is skipped and the rest of the message still goes through
+    size_t applied = 0;
+    for (auto graph : graphs_array) {
+        // add graph to keep track of
+        if (g >= graphs.size())
+            graphs.emplace_back();
+        graph_t &target = graphs[g];
+
+        ondemand::object fields;
+        if (graph.get_object().get(fields)) {
+            g++;
+            continue;
+        }
 
-                                        auto v = color.get_string();
-                                        auto vw = v.value();
-                                        graphs[g].colors[count] = get_color(vw);
+        // a single pass in whatever order the fields come, the layout ones are only fingerprinted since they hardly
+        // ever change between messages, the data goes straight into values
+        size_t schema = 0xcbf29ce484222325;
+        bool has_data = false;
+        for (auto field : fields) {
+            const graph_key key = classify_graph_key(field.key().value());
+            std::string_view raw;
+            ondemand::array array;
+            switch (key) {
+            case graph_key::title:
+            case graph_key::limit:
+                if (!field.value().raw_json_token().get(raw))
+                    schema = schema_mix(schema, key, raw);
+                break;
+            case graph_key::labels:
+            case graph_key::colors:
+                if (!field.value().get_array().get(array) && !array.raw_json().get(raw))
+                    schema = schema_mix(schema, key, raw);
+                break;
+            case graph_key::data: {
+                if (field.value().get_array().get(array))
+                    break;
+                has_data = true;
+                target.samples.push_row(timestamp);
+                size_t count = 0;
+                for (auto value : array) {
+                    add_slot(stream, target, count);
+                    target.samples.set(count, (float)(double)value);
+                    count++;
+                }
+                target.slots = count;
+                break;
+            }
+            default:
+                break;
+            }
+        }
 
-                                        count++;
-                                    }
-                                }
+        if (schema != target.schema) {
+            // new or changed layout, go over the fields once more for it
+            // only remembered once all of it went through, a label that failed to parse gets another go next time
+            fields.reset();
+            decode_layout(stream, target, fields);
+            target.schema = schema;
+        }
+        applied += has_data;
+        g++;
+    }
+    return applied ? decode_status::ok : decode_status::no_data;
+}
 
-                                size_t limit = 60;
-                                if (auto pd_err = graph["pd"].get(limit)) {
-                                    // err
-                                } else {
-                                    // clamp to at least 1 data point
-                                    graphs[g].limit = limit > 0 ? limit : 1;
-                                }
+// decodes one cobs frame (plotter_binary.h) into stream.graphs, g ends up as the graph it was about
+decode_status decode_packet(stream_t &stream, const uint8_t *frame, size_t size, size_t &g) {
+    real::vector<graph_t> &graphs = stream.graphs;
+    g = 0;
+    if (size >= plotter_binary_max_frame)
+        return decode_status::malformed;
+    const size_t length = plotter_binary_unframe(frame, size, stream.packet);
+    if (!plotter_binary_check(stream.packet, length))
+        return decode_status::malformed;
+
+    plotter_binary_reader in(stream.packet, length - 2);
+    const uint8_t type = in.u8();
+    const uint8_t index = in.u8();
+    while (index >= graphs.size())
+        graphs.emplace_back();
+    graph_t &graph = graphs[index];
+
+    if (type == plotter_binary_schema) {
+        const uint16_t limit = in.u16();
+        const float scale = in.f32();
+        const uint8_t slots = in.u8();
+        const char *text;
+        const size_t title_length = in.text(text);
+        if (!in.ok)
+            return decode_status::malformed;
+        graph.title.assign(text, title_length);
+        set_limit(stream, graph, limit);
+        graph.scale = scale;
+        for (size_t s = 0; s < slots; s++) {
+            const char *label;
+            const size_t label_length = in.text(label);
+            const size_t color_length = in.text(text);
+            if (!in.ok)
+                return decode_status::malformed;
+            add_slot(stream, graph, s);
+            graph.labels[s].assign(label, label_length);
+            // without a color name the label picks one, same as json
+            graph.colors[s] = get_color(color_length ? std::string_view{text, color_length}
+                                                     : std::string_view{label, label_length});
+        }
+        // a json message for this graph has to set it up again
+        graph.schema = 0;
+    } else if (type == plotter_binary_float_samples || type == plotter_binary_int16_samples) {
+        const uint32_t ts = in.u32();
+        const size_t width = type == plotter_binary_float_samples ? 4 : 2;
+        if (!in.ok || in.remaining() % width)
+            return decode_status::malformed;
+        const size_t count = in.remaining() / width;
+        graph.samples.push_row((double)ts);
+        for (size_t s = 0; s < count; s++) {
+            add_slot(stream, graph, s);
+            graph.samples.set(s, type == plotter_binary_float_samples ? in.f32() : in.i16() * graph.scale);
+        }
+        graph.slots = count;
+    } else {
+        return decode_status::malformed;
+    }
+    g = index + 1;
+    return decode_status::ok;
+}
 
-                                float mn = std::numeric_limits<float>::max();
-                                float mx = std::numeric_limits<float>::min();
-                                uint32_t count = 0;
-                                float flt_ts = ts;
+// decodes every complete binary packet in stream.buffer, returns the number of graphs to draw
+// hands the stream back to the json path once a run too long to be a packet shows up
+size_t handle_binary(stream_t &stream) {
+    const uint8_t *data = (const uint8_t *)stream.buffer.data();
+    const size_t size = stream.buffer.size();
+    size_t graphs_to_display = 0;
+    size_t begin = 0;
+    while (begin < size) {
+        const uint8_t *zero = (const uint8_t *)std::memchr(data + begin, 0, size - begin);
+        if (!zero)
+            break;
+        const size_t end = zero - data;
+        // back to back delimiters are allowed, a board can send one to flush out a partial packet
+        if (end > begin) {
+            size_t g = 0;
+            if (decode_packet(stream, data + begin, end - begin, g) == decode_status::ok) {
+                stream.objects_parsed++;
+                stream.binary_graphs = g > stream.binary_graphs ? g : stream.binary_graphs;
+                graphs_to_display = stream.binary_graphs;
+            } else {
+                stream.dropped_bytes += end - begin;
+                stream.truncated_objects++;
+            }
+        }
+        begin = end + 1;
+    }
+    stream.consume(begin);
 
-                                ondemand::array data_points;
-                                if (auto d_err = graph["d"].get_array().get(data_points)) {
-                                    return false;
-                                } else {
-                                    // go through data points;
-                                    for (auto value : data_points) {
-                                        if (count >= graphs[g].values.size()) {
-                                            graphs[g].values.emplace_back();
-                                            graphs[g].values[count].reserve(graphs[g].limit);
-                                            graphs[g].labels.emplace_back("");
-                                            graphs[g].colors.emplace_back(ctx->style.chart.color);
-                                        }
+    if (stream.buffer.size() >= plotter_binary_max_frame) {
+        // no delimiter for longer than any packet can be, the device went back to text
+        stream.format = stream_format::json;
+        stream.framer.reset();
+        stream.validated = 0;
+    }
+    return graphs_to_display;
+}
 
-                                        struct nk_vec2 point;
-                                        point.x = flt_ts;
-                                        point.y = (float)(double)value;
-                                        graphs[g].values[count].emplace_back(point);
-                                        //
-                                        if (graphs[g].values[count].size() > graphs[g].limit) {
-                                            graphs[g].values[count].erase(graphs[g].values[count].begin());
-                                        }
+// series colors for text lines, by position since the lines rarely name one
+nk_color line_color(size_t slot) {
+    static const nk_color palette[] = {get_color("green"), get_color("orange"), get_color("cyan"),
+                                       get_color("yellow"), get_color("red"), get_color("pink"),
+                                       get_color("purple"), get_color("blue"), get_color("white")};
+    return palette[slot % (sizeof(palette) / sizeof(palette[0]))];
+}
 
-                                        count++;
-                                    }
-                                    graphs[g].slots = count;
-                                    g++;
-                                }
-                            }
-                            // send the object out to console, make room from the start
-                            if (v.size() > (cout_buffer.capacity() - cout_buffer.size())) {
-                                if (v.size() > cout_buffer.capacity())
-                                    cout_buffer.reserve(cout_buffer.capacity() * 2);
-                                cout_buffer.erase(size_t{0}, v.size());
-                            }
-                            // fmt::format_to(std::back_inserter(cout_buffer), "{}", v);
-                            cout_buffer.append(v);
-                            // erase whatever we just read
-                            stream_buffer.erase(size_t{0}, (v.data() + v.size()) - stream_buffer.data());
-                        }
-                    }
-                } catch (const std::exception &err) {
-                    cout_buffer.clear();
-                    fmt::format_to(std::back_inserter(cout_buffer), "{}\n\n{}", err.what(), v);
-                    // format_out("{}\n\n", err.what(), v); // shouldn't allocate in a catch block
-                    g = 0;
-                    stream_buffer.erase(stream_buffer.begin());
-                    return graphs_to_display;
-                }
-                graphs_to_display = g > 0 ? g : graphs_to_display;
-#endif
-            } else {
-                stream_buffer.erase(size_t{0}, dist ? dist : size_t{1});
-                // stream_buffer.erase(stream_buffer.begin());
-                return graphs_to_display = 0;
+// decodes one text line (line_protocol.h) into the stream's first graph
+decode_status decode_line(stream_t &stream, const char *first, const char *last) {
+    constexpr size_t max_fields = 64;
+    plot_field fields[max_fields];
+    size_t count = parse_plot_line(first, last, fields, max_fields);
+    count = count < max_fields ? count : max_fields;
+    if (!count)
+        return decode_status::no_data;
+
+    if (stream.graphs.empty())
+        stream.graphs.emplace_back();
+    graph_t &graph = stream.graphs[0];
+    auto slot = [&](size_t s) {
+        if (s < graph.samples.slots())
+            return;
+        add_slot(stream, graph, s);
+        graph.colors[s] = line_color(s);
+        graph.labels[s].clear();
+        fmt::format_to(std::back_inserter(graph.labels[s]), "value {}", s + 1);
+    };
+
+    size_t numbers = 0;
+    for (size_t f = 0; f < count; f++)
+        numbers += fields[f].number;
+    if (!numbers) {
+        // a line of words names the series, anything else without a number is noise
+        for (size_t f = 0; f < count; f++) {
+            if (!fields[f].label.empty())
+                return decode_status::malformed;
+        }
+        for (size_t f = 0; f < count; f++) {
+            slot(f);
+            graph.labels[f] = fields[f].text;
+        }
+        return decode_status::no_data;
+    }
+
+    // lines don't carry a time, the x axis counts samples like the arduino ide's plotter does
+    graph.samples.push_row((double)stream.line_samples++);
+    size_t s = 0;
+    for (size_t f = 0; f < count; f++) {
+        if (!fields[f].number)
+            continue;
+        slot(s);
+        if (!fields[f].label.empty() && fields[f].label != graph.labels[s])
+            graph.labels[s] = fields[f].label;
+        graph.samples.set(s, fields[f].value);
+        s++;
+    }
+    graph.slots = s;
+    // a json message for this graph has to set it up again
+    graph.schema = 0;
+    return decode_status::ok;
+}
+
+// decodes every complete text line in the first size bytes of stream.buffer, returns the number of graphs to draw
+// hands the stream back to the json path once a line opens an object, or one gets longer than any plot line would
+size_t handle_lines(stream_t &stream, size_t size) {
+    // labels end up on screen, so the same repair as json
+    stream.validate_utf8(size);
+    const char *data = stream.buffer.data();
+    real::vector<size_t> &ends = stream.line_ends;
+    ends.clear();
+    find_line_ends(data, stream.lines_scanned, size, ends);
+    stream.lines_scanned = size;
+
+    size_t graphs_to_display = 0;
+    size_t begin = 0;
+    for (size_t l = 0; l < ends.size(); l++) {
+        const char *first = data + begin;
+        const char *last = data + ends[l];
+        const char *text = first;
+        while (text != last && (*text == ' ' || *text == '\t' || *text == '\r'))
+            text++;
+        if (text != last && *text == '{') {
+            stream.consume(begin);
+            stream.format = stream_format::json;
+            stream.framer.reset();
+            return graphs_to_display;
+        }
+
+        const decode_status status = decode_line(stream, first, last);
+        if (status == decode_status::ok) {
+            stream.objects_parsed++;
+            graphs_to_display = 1;
+        } else if (status == decode_status::malformed) {
+            stream.dropped_bytes += last - first;
+            stream.truncated_objects++;
+        }
+        begin = ends[l] + 1;
+    }
+    stream.consume(begin);
+
+    if (stream.buffer.size() >= max_line_bytes) {
+        stream.format = stream_format::json;
+        stream.framer.reset();
+    }
+    return graphs_to_display;
+}
+
+// send the object out to console, make room from the start
+void log_object(std::string &log, std::string_view v) {
+    if (v.size() > (log.capacity() - log.size())) {
+        if (v.size() > log.capacity())
+            log.reserve(log.capacity() * 2);
+        log.erase(size_t{0}, v.size());
+    }
+    // fmt::format_to(std::back_inserter(log), "{}", v);
+    log.append(v);
+}
+
+// parses the json objects in the first size bytes of stream.buffer, parsed objects are echoed to log
+// returns the number of graphs to draw, 0 -> no data / no change
+size_t handle_objects(stream_t &stream, std::string &log, size_t size) {
+    ondemand::parser &parser = stream.parser;
+    real::padded_buffer &stream_buffer = stream.buffer;
+    real::vector<json_framer::frame> &frames = stream.frames;
+
+    size_t graphs_to_display = 0;
+    // only new bytes are checked, invalid ones are replaced rather than holding up the stream
+    stream.validate_utf8(size);
+
+    // every complete object buffered right now, only complete objects come out of the framer so one still arriving
+    // costs nothing until its last byte is in
+    // nothing is consumed until they've all been decoded, so the offsets stay put
+    const char *data = stream_buffer.data();
+    frames.clear();
+    json_framer::frame frame;
+    while (stream.framer.next(data, size, frame))
+        frames.emplace_back(frame);
+
+    // bookkeeping once frames[f] has been decoded, or failed to
+    auto settle = [&](size_t f, decode_status status, size_t g) {
+        std::string_view v{data + frames[f].begin, frames[f].end - frames[f].begin};
+        if (status == decode_status::ok) {
+            log_object(log, v);
+            stream.objects_parsed++;
+            graphs_to_display = g > 0 ? g : graphs_to_display;
+        } else {
+            stream.dropped_bytes += v.size();
+            stream.truncated_objects++;
+        }
+    };
+    auto report = [&](size_t f, const std::exception &err) {
+        std::string_view v{data + frames[f].begin, frames[f].end - frames[f].begin};
+        log.clear();
+        fmt::format_to(std::back_inserter(log), "{}\n\n{}", err.what(), v);
+        // format_out("{}\n\n", err.what(), v); // shouldn't allocate in a catch block
+    };
+
+    auto decode_single = [&](size_t f) {
+        // whatever follows the object in the buffer is the padding simdjson needs
+        padded_string_view json(data + frames[f].begin, frames[f].end - frames[f].begin,
+                                stream_buffer.padded_capacity(frames[f].begin));
+        ondemand::document graph_data;
+        decode_status status = decode_status::malformed;
+        size_t g = 0;
+        try {
+            if (!parser.iterate(json).get(graph_data))
+                status = decode_object(stream, graph_data, g);
+        } catch (const std::exception &err) {
+            report(f, err);
+            status = decode_status::malformed;
+        }
+        settle(f, status, g);
+    };
+
+    // objects only whitespace apart go to simdjson as one document stream, a single stage 1 pass over all of them
+    // returns the first frame that still has to be decoded, anything simdjson balks at is retried one at a time
+    auto decode_batch = [&](size_t first, size_t last) -> size_t {
+        const size_t begin = frames[first].begin;
+        const size_t length = frames[last - 1].end - begin;
+        ondemand::document_stream docs;
+        // one batch holds all of them, so simdjson never needs its stage 1 thread
+        if (parser.iterate_many(data + begin, length, length).get(docs))
+            return first;
+        size_t f = first;
+        try {
+            for (auto it = docs.begin(); it != docs.end() && f < last; ++it) {
+                ondemand::document_reference graph_data;
+                // simdjson and the framer have to agree on where the object is
+                if ((*it).get(graph_data) || begin + it.current_index() != frames[f].begin)
+                    return f;
+                size_t g = 0;
+                settle(f, decode_object(stream, graph_data, g), g);
+                f++;
             }
+        } catch (const std::exception &err) {
+            report(f, err);
+            settle(f, decode_status::malformed, 0);
+            return f + 1;
+        }
+        return f;
+    };
+
+    size_t previous_end = 0;
+    for (size_t f = 0; f < frames.size();) {
+        // anything but whitespace before an object is lost data
+        const size_t skipped = count_garbage(data + previous_end, data + frames[f].begin);
+        stream.dropped_bytes += skipped;
+        stream.resyncs += skipped != 0;
+
+        size_t run = f + 1;
+        while (run < frames.size() && !count_garbage(data + frames[run - 1].end, data + frames[run].begin))
+            run++;
+
+        size_t next = run - f > 1 ? decode_batch(f, run) : f;
+        for (; next < run; next++)
+            decode_single(next);
+
+        previous_end = frames[run - 1].end;
+        f = run;
+    }
+    // erase whatever we just read
+    if (frames.size())
+        stream.consume(previous_end);
+
+    // nothing before the next '{' can be used, unless the device is printing plain lines of numbers
+    // a device printing a line at a time only shows that over several calls, so text that could still go either way
+    // stays in the buffer until it can tell, up to a line's worth of it
+    const size_t garbage = stream.framer.garbage();
+    if (!frames.size() && garbage) {
+        const plot_lines_guess guess = guess_plot_lines(stream_buffer.data(), garbage);
+        if (guess == plot_lines_guess::yes) {
+            // the first line may have been cut off
+            stream.resync((const char *)std::memchr(stream_buffer.data(), '\n', garbage) - stream_buffer.data() + 1);
+            stream.framer.reset();
+            stream.format = stream_format::lines;
+            stream.lines_scanned = 0;
+            return graphs_to_display;
+        }
+        if (guess == plot_lines_guess::undecided) {
+            if (garbage <= max_line_bytes)
+                return graphs_to_display;
+            // keep the last '\n' so the line after it counts as a whole one
+            const size_t last = std::string_view{stream_buffer.data(), garbage}.rfind('\n');
+            stream.resync(last != std::string_view::npos && garbage - last <= max_line_bytes ? last : garbage);
+            return graphs_to_display;
+        }
+    }
+    if (garbage)
+        stream.resync(garbage);
+    return graphs_to_display;
+}
 
-        } while (stream_buffer.size() >= 512);
-        return graphs_to_display;
-    } else {
+// parses whatever has been committed to stream.buffer, json objects, binary packets (plotter_binary.h) or text lines
+// (line_protocol.h), whichever the device is sending
+// returns the number of graphs to draw, 0 -> no data / no change
+size_t handle_json(stream_t &stream, std::string &log) {
+    // the framers pick up where they left off, so parsing whatever arrived costs nothing for a message that isn't
+    // complete yet, how long bytes wait to be batched up is up to the caller (see read_scheduler)
+    size_t graphs_to_display = 0;
+    if (!stream.buffer.size())
         return graphs_to_display;
+
+    // a binary packet ends any text in front of it, the text handlers only get to see up to there
+    const size_t size = stream.buffer.size();
+    const size_t packet = stream.format == stream_format::binary ? json_framer::npos : stream.find_binary();
+    const size_t text_end = packet == json_framer::npos ? size : packet;
+    // a handler that sees the device switch formats hands over, the next one carries on in the same call
+    for (size_t handovers = 0; handovers < 3; handovers++) {
+        const stream_format format = stream.format;
+        const size_t end = text_end - (size - stream.buffer.size());
+        size_t g = 0;
+        if (format == stream_format::binary)
+            g = handle_binary(stream);
+        else if (format == stream_format::lines)
+            g = handle_lines(stream, end);
+        else
+            g = handle_objects(stream, log, end);
+        graphs_to_display = g ? g : graphs_to_display;
+        if (stream.format == format)
+            break;
     }
+
+    if (packet != json_framer::npos) {
+        // anything left in front of the packet is a message that never finished
+        stream.resync(packet - (size - stream.buffer.size()));
+        stream.framer.reset();
+        stream.format = stream_format::binary;
+        stream.binary_graphs = 0;
+        if (size_t g = handle_binary(stream))
+            graphs_to_display = g;
+    }
+    return graphs_to_display;
+}
+// copies read_count bytes into stream.buffer and parses them
+size_t handle_json(stream_t &stream, std::string &log, const char *ptr, uint32_t read_count) {
+    if (!read_count)
+        return 0;
+    stream.buffer.append(ptr, read_count);
+    return handle_json(stream, log);
 }
 
+// a connected board (or any other data_source): the thread reading it, the worker parsing what was read and the
+// queue writing commands back to it
+// the worker owns stream.buffer and stream.parser, everything else it touches is guarded by mutex
+struct device_t {
+    std::string path;
+    std::unique_ptr<data_source> source;
+    serial_reader reader;
+    tx_queue tx;
+    read_scheduler scheduler;
+
+    std::mutex mutex;
+    stream_t stream;
+    std::string log;
+    size_t graphs_to_display = 0;
+    size_t last_read_timestamp = 0;
+
+    // set by the ui, picked up by the worker
+    std::atomic<size_t> latency_target_ns = 16'000'000;
+    std::atomic<size_t> ram_budget = 0;
+    // published by the worker for the ui
+    std::atomic<size_t> cadence_ns = 0;
+    std::atomic<double> arrival_rate = 0.0;
+
+    std::jthread worker;
+
+    device_t() { log.reserve(1024); }
+    ~device_t() { stop(); }
+
+    void start(uint32_t baud_rate) {
+        size_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+        scheduler.latency_target_ns = latency_target_ns.load(std::memory_order_relaxed);
+        // 8N1 framing puts 10 bits on the wire per byte
+        scheduler.reset(baud_rate / 10, now, reader.bytes_read.load(std::memory_order_relaxed));
+        cadence_ns.store(scheduler.interval_ns, std::memory_order_relaxed);
+        last_read_timestamp = now;
+        reader.start(*source);
+        tx.start(*source);
+        worker = std::jthread([this](std::stop_token stop) {
+            while (!stop.stop_requested()) {
+                size_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+                scheduler.latency_target_ns = latency_target_ns.load(std::memory_order_relaxed);
+                cadence_ns.store(scheduler.update(now, reader.bytes_read.load(std::memory_order_relaxed)),
+                                 std::memory_order_relaxed);
+                arrival_rate.store(scheduler.arrival_rate, std::memory_order_relaxed);
+                if (!scheduler.due(now, last_read_timestamp, reader.bytes_in_flight(), reader.ring.capacity(),
+                                   read_scheduler::ends_message(reader.ring.back()))) {
+                    size_t wait = scheduler.interval_ns - (now - last_read_timestamp);
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(wait < 1'000'000 ? wait : 1'000'000));
+                    continue;
+                }
+                last_read_timestamp = now;
+
+                size_t in_flight = reader.bytes_in_flight();
+                if (!in_flight)
+                    continue;
+                std::span<char> tail = stream.buffer.prepare(in_flight);
+                stream.buffer.commit(reader.ring.read(tail.data(), in_flight));
+
+                std::lock_guard<std::mutex> lock(mutex);
+                set_ram_budget(stream, ram_budget.load(std::memory_order_relaxed));
+                size_t g = handle_json(stream, log);
+                graphs_to_display = (g > 0 && g != graphs_to_display) ? g : graphs_to_display;
+            }
+        });
+    }
+
+    void stop() {
+        if (worker.joinable()) {
+            worker.request_stop();
+            worker.join();
+        }
+        tx.stop();
+        reader.stop();
+        if (source)
+            source->Disconnect();
+    }
+};
+
 void clear_data(real::vector<graph_t> &graphs) {
     for (size_t i = 0; i < graphs.size(); i++) {
-        for (size_t s = 0; s < graphs[s].values.size(); s++)
-            graphs[i].values[s].clear();
+        graphs[i].samples.clear();
+        graphs[i].labels.clear();
         graphs[i].colors.clear();
         graphs[i].title.clear();
         graphs[i].points.clear();
+        graphs[i].schema = 0;
 
         graphs[i].upper_value.value = 0.0f;
         graphs[i].lower_value.value = 0.0f;
@@ -984,6 +1585,76 @@ void nk_scroll(struct nk_context *ctx, float v) {
     win->edit.scrollbar.y = v;
 }
 
+// parses each source to exhaustion on this thread without opening a window, then reports the throughput
+// sources that never end (generators, live ports) are cut off after duration_s seconds if it's set
+int run_headless(const real::vector<std::string_view> &specs, uint32_t baud_rate, double duration_s,
+                 size_t ram_budget, size_t read_size) {
+    const double ns_per_second = 1'000'000'000.0;
+    for (size_t i = 0; i < specs.size(); i++) {
+        std::unique_ptr<data_source> source = open_source(specs[i], baud_rate);
+        if (!source) {
+            fmt::print("could not open {}\n", specs[i]);
+            return 1;
+        }
+
+        stream_t stream;
+        stream.ram_budget = ram_budget;
+        std::string log;
+        log.reserve(1024);
+        size_t bytes = 0;
+        size_t start = std::chrono::steady_clock::now().time_since_epoch().count();
+        size_t deadline = duration_s > 0.0 ? start + (size_t)(duration_s * ns_per_second) : SIZE_MAX;
+        while (source->IsConnected() &&
+               (size_t)std::chrono::steady_clock::now().time_since_epoch().count() < deadline) {
+            if (!source->WaitReadable(100))
+                continue;
+            std::span<char> tail = stream.buffer.prepare(read_size);
+            int read_count = source->ReadData(tail.data(), (unsigned int)tail.size());
+            if (read_count <= 0)
+                continue;
+            stream.buffer.commit(read_count);
+            bytes += read_count;
+            handle_json(stream, log);
+        }
+        size_t end = std::chrono::steady_clock::now().time_since_epoch().count();
+
+        double seconds = (double)(end - start) / ns_per_second;
+        seconds = seconds > 0.0 ? seconds : 1.0 / ns_per_second;
+        fmt::print("{}: {} bytes, {} objects in {:.3f}s ({:.2f} MB/s, {:.0f} objects/s)\n", specs[i], bytes,
+                   stream.objects_parsed, seconds, (double)bytes / seconds / 1'000'000.0,
+                   (double)stream.objects_parsed / seconds);
+        const size_t unterminated = stream.framer.oversized + stream.framer.restarts;
+        if (stream.dropped_bytes || stream.truncated_objects || unterminated)
+            fmt::print("{}: dropped {} bytes in {} resyncs, {} truncated objects, {} never closed\n", specs[i],
+                       stream.dropped_bytes, stream.resyncs, stream.truncated_objects, unterminated);
+        if (stream.invalid_utf8_bytes)
+            fmt::print("{}: replaced {} invalid utf-8 bytes in {} runs\n", specs[i], stream.invalid_utf8_bytes,
+                       stream.invalid_utf8_regions);
+        size_t rows = 0;
+        size_t spilled = 0;
+        size_t spill_bytes = 0;
+        for (size_t g = 0; g < stream.graphs.size(); g++) {
+            const sample_columns &samples = stream.graphs[g].samples;
+            rows += samples.rows();
+            spilled += samples.timestamps.cold_size();
+            spill_bytes += samples.timestamps.cold_chunks() * spill_chunk<double>::rows * sizeof(double);
+            for (size_t s = 0; s < samples.slots(); s++)
+                spill_bytes += samples.values[s].cold_chunks() * spill_chunk<float>::rows * sizeof(float);
+        }
+        if (spilled)
+            fmt::print("{}: kept {} rows, {} spilled to {} MB of mapped chunks\n", specs[i], rows, spilled,
+                       spill_bytes / 1'000'000);
+#ifndef _WIN32
+        if (generator_source *generated = dynamic_cast<generator_source *>(source.get()))
+            fmt::print("{}: generated {} messages, {} bytes, {} stalls, {} bytes written back\n", specs[i],
+                       generated->generator.messages_sent.load(), generated->generator.bytes_sent.load(),
+                       generated->generator.stalls.load(), generated->generator.bytes_received.load());
+#endif
+    }
+    remove_spill_directory();
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     pcg32_random_t rng;
     rng.inc = (ptrdiff_t)&rng;
@@ -991,14 +1662,53 @@ int main(int argc, char *argv[]) {
     rng.state = std::chrono::steady_clock::now().time_since_epoch().count();
     pcg32_random_r(&rng);
 
-    simdjson::ondemand::parser parser;
+    // ArduinoSerialPlotter [--headless] [--duration <seconds>] [--baud <rate>] [--ram-budget <MB>]
+    //                      [--spill-dir <path>] [--read-size <bytes>] [source...]
+    // sources are opened as devices on startup, see open_source for the syntax
+    const size_t bytes_per_mb = 1'000'000;
+    bool headless = false;
+    int baud_rate = 115200;
+    double duration_s = 0.0;
+    // megabytes of samples each graph keeps in ram, the rest of a long history is spilled to disk, 0 keeps it all
+    int ram_budget_mb = 0;
+    // most bytes a headless read takes, a small one checks that parsing doesn't depend on how reads are split up
+    int read_size = 1 << 16;
+    real::vector<std::string_view> startup_sources;
+    for (int a = 1; a < argc; a++) {
+        std::string_view arg{argv[a]};
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--baud" && (a + 1) < argc) {
+            std::string_view rate{argv[++a]};
+            std::from_chars(rate.data(), rate.data() + rate.size(), baud_rate);
+        } else if (arg == "--duration" && (a + 1) < argc) {
+            std::string_view seconds{argv[++a]};
+            std::from_chars(seconds.data(), seconds.data() + seconds.size(), duration_s);
+        } else if (arg == "--ram-budget" && (a + 1) < argc) {
+            std::string_view megabytes{argv[++a]};
+            std::from_chars(megabytes.data(), megabytes.data() + megabytes.size(), ram_budget_mb);
+            ram_budget_mb = ram_budget_mb > 0 ? ram_budget_mb : 0;
+        } else if (arg == "--spill-dir" && (a + 1) < argc) {
+            spill_root = argv[++a];
+        } else if (arg == "--read-size" && (a + 1) < argc) {
+            std::string_view bytes{argv[++a]};
+            std::from_chars(bytes.data(), bytes.data() + bytes.size(), read_size);
+            read_size = read_size > 0 ? read_size : 1;
+        } else {
+            startup_sources.emplace_back(arg);
+        }
+    }
+    if (headless)
+        return run_headless(startup_sources, baud_rate, duration_s, (size_t)ram_budget_mb * bytes_per_mb,
+                            (size_t)read_size);
 
+    // fed by the demo and the input tab, each connected device has its own stream
+    stream_t local_stream;
     // pcg32_random_r
-    real::vector<graph_t> graphs;
+    real::vector<graph_t> &graphs = local_stream.graphs;
     graphs.reserve(32);
 
     cout_buffer.reserve(1024);
-    stream_buffer.reserve(4096);
     /*GUI THINGS*/
     /* Platform */
     static GLFWwindow *win;
@@ -1039,6 +1749,7 @@ int main(int argc, char *argv[]) {
     }
 
     ctx = nk_glfw3_init(win, NK_GLFW3_INSTALL_CALLBACKS, MAX_VERTEX_BUFFER, MAX_ELEMENT_BUFFER);
+    local_stream.default_color = ctx->style.chart.color;
 
     // load fonts
     {
@@ -1065,12 +1776,7 @@ int main(int argc, char *argv[]) {
     int xticks = 4;
     int yticks = 4;
 
-    size_t mx_width = 1024;
     size_t alloc_width = 1024 + SIMDJSON_PADDING;
-    char *ptr = (char *)calloc(alloc_width, 1);
-    size_t sz = _msize(ptr);
-    sz = sz > alloc_width ? sz : alloc_width;
-
     char *edit_ptr = (char *)calloc(alloc_width, 1);
     size_t edit_sz = _msize(edit_ptr);
     edit_sz = edit_sz > alloc_width ? edit_sz : alloc_width;
@@ -1082,41 +1788,44 @@ int main(int argc, char *argv[]) {
 
     char *compath = (char *)calloc(128, 1);
     size_t compath_sz = 128;
-    // don't connect
-    Serial SerialPort{};
-
-    auto SerialPorts = SerialPort.ListAvailable();
+    // ports present on the system, kept current as devices are plugged in and out
+    port_cache ports;
+    // the combo's item list, rebuilt only when the ports change
+    real::vector<const char *> port_names;
+    uint64_t port_names_generation = 0;
+    int selected_port = 0;
+    real::vector<std::unique_ptr<device_t>> devices;
+    // which log the data tab shows, 0 is our own, 1... are the devices
+    int data_source_index = 0;
+    // where the input tab sends to, 0 parses it here, 1... queues it for that device
+    int input_target = 0;
+    // transmit pacing in bytes per second, 0 is off
+    int tx_pacing = 0;
+
+    char source_spec[256] = {};
+    size_t source_spec_sz = sizeof(source_spec);
+    int source_spec_len[2] = {0, 0};
+
+    ports.poll();
     // go to fill in first available port
-    for (size_t i = 0; i < SerialPorts.size(); i++) {
-        if (SerialPorts[i]) {
-            size_t port_num = get_lsb_set(SerialPorts[i]);
-            auto result = std::to_chars(txtedit, (txtedit + txtedit_sz), port_num);
-            *result.ptr = 0;
-            txtedit_len[0] = result.ptr - txtedit;
-            break;
-        }
+    if (ports.ports().size()) {
+        auto result = std::to_chars(txtedit, (txtedit + txtedit_sz), ports.ports()[0].number);
+        *result.ptr = 0;
+        txtedit_len[0] = result.ptr - txtedit;
     }
 
-    int read_count = 0;
     int edit_count = 0;
-    // make sure we 0
-    ptr[0] = 0;
-    char *bufend = ptr;
-    size_t i = 0;
 
     std::string comport_path;
     std::string graph_title;
     std::string edit_string;
 
-    size_t last_timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
-    size_t last_ok_timestamp = last_timestamp;
+    size_t last_ok_timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
 
     int demo_mode = true;
     int data_auto_scroll = true;
     int example_json_mode = false;
 
-    int baud_rate = 115200;
-
     size_t graphs_to_display = 0;
 
     float zoom_factor = 0.20;
@@ -1131,16 +1840,32 @@ int main(int argc, char *argv[]) {
 
     int fps_delay = 16;
 
-    const size_t bytes_per_second = baud_rate / 8;
-    const size_t full_buffer = (mx_width - (2 * SIMDJSON_PADDING));
     const size_t ns_per_second = 1'000'000'000;
-    const size_t ms_per_ns = 1'000'000;
-
-    size_t baud_delay = ((full_buffer * ns_per_second) / bytes_per_second) + (2 * ms_per_ns);
-
-    size_t frame_rate_delay = 33'000'000;
-    size_t delay = 33'000'000;
-    delay = NK_MIN(baud_delay, frame_rate_delay);
+    const size_t ns_per_ms = 1'000'000;
+
+    // the longest a device's bytes may wait to be batched up before being parsed, slow devices are parsed as soon as
+    // a message is complete and fast ones adapt their cadence within it
+    int latency_target_ms = 16;
+
+    auto add_device = [&](std::unique_ptr<data_source> source, std::string_view name) {
+        std::unique_ptr<device_t> device = std::make_unique<device_t>();
+        device->path = name;
+        device->source = std::move(source);
+        device->stream.default_color = ctx->style.chart.color;
+        device->latency_target_ns = latency_target_ms * ns_per_ms;
+        device->ram_budget = (size_t)ram_budget_mb * bytes_per_mb;
+        device->start(baud_rate);
+        devices.emplace_back(std::move(device));
+        demo_mode = false;
+    };
+
+    for (size_t i = 0; i < startup_sources.size(); i++) {
+        std::unique_ptr<data_source> source = open_source(startup_sources[i], baud_rate);
+        if (source)
+            add_device(std::move(source), startup_sources[i]);
+        else
+            fmt::format_to(std::back_inserter(cout_buffer), "could not open {}\n", startup_sources[i]);
+    }
     /* Turn on VSYNC */
     glfwSwapInterval(vsync);
     size_t previous_timestamp = 0;
@@ -1165,49 +1890,103 @@ int main(int argc, char *argv[]) {
 
                 nk_property_int(ctx, "Baud", 9600, &baud_rate, INT_MAX, 1, 1.0f);
 
-                if (SerialPort.IsConnected()) {
+                if (devices.size()) {
                     if (demo_mode) { // if we were in demo mode clear data
                         clear_data(graphs);
                         graphs_to_display = 0;
                     }
                     demo_mode = false;
-                    if (nk_button_label(ctx, "Disconnect")) {
-                        SerialPort.Disconnect();
-                    }
-                } else {
-                    if (nk_button_label(ctx, "Connect")) {
-                        comport_path.clear();
+                }
+                if (nk_button_label(ctx, "Connect")) {
+                    comport_path.clear();
+                    uint32_t port_num = 0;
+                    std::from_chars(txtedit, txtedit + (size_t)txtedit_len[0], port_num, 10);
+                    // the port Connect(port_num) opens (ttyACM or ttyUSB), so the device list and the duplicate
+                    // check name the one that's actually open
+                    char port_path[64];
+                    if (Serial::PortPath((int)port_num, port_path)) {
+                        comport_path = port_path;
+                    } else {
+#ifdef _WIN32
                         fmt::format_to(std::back_inserter(comport_path), std::string_view{"\\\\.\\COM{}"},
                                        std::string_view{txtedit, (size_t)txtedit_len[0]});
+#else
+                        fmt::format_to(std::back_inserter(comport_path), std::string_view{"/dev/ttyACM{}"},
+                                       std::string_view{txtedit, (size_t)txtedit_len[0]});
+#endif
+                    }
+                    bool already_connected = false;
+                    for (size_t d = 0; d < devices.size(); d++)
+                        already_connected = already_connected || devices[d]->path == comport_path;
 
-                        // print_out(std::string_view{"attempting to connect to {}...\n"}, comport_path);
-                        fmt::format_to(std::back_inserter(cout_buffer), "attempting to connect to {}...", comport_path);
+                    // print_out(std::string_view{"attempting to connect to {}...\n"}, comport_path);
+                    fmt::format_to(std::back_inserter(cout_buffer), "attempting to connect to {}...", comport_path);
 
-                        uint32_t port_num = 0;
-                        std::from_chars(txtedit, (txtedit + ((size_t)txtedit_len)), port_num, 10);
-                        int result = SerialPort.Connect(port_num, false, baud_rate);
+                    int result = 0;
+                    if (!already_connected) {
+                        std::unique_ptr<serial_source> source = std::make_unique<serial_source>();
+                        result = source->port.Connect(port_num, false, baud_rate);
                         if (result == 0)
-                            result = SerialPort.Connect(comport_path.data(), false, baud_rate);
-                        // print_out(std::string_view{"{}"}, result != 0 ? std::string_view{"success!"} :
-                        // std::string_view{"failed!"});
-                        fmt::format_to(std::back_inserter(cout_buffer), std::string_view{"{}"},
-                                       result != 0 ? std::string_view{"success!"} : std::string_view{"failed!"});
-
-                        if (result) {
-                            const size_t bytes_per_second = baud_rate / 8;
-                            const size_t full_buffer = (mx_width - (2 * SIMDJSON_PADDING));
-                            const size_t ns_per_second = 1'000'000'000;
-                            const size_t ns_per_ms = 1'000'000;
-
-                            size_t baud_delay = ((full_buffer * ns_per_second) / bytes_per_second) + (2 * ns_per_ms);
-                            delay = baud_delay;
-                        }
+                            result = source->port.Connect(comport_path.data(), false, baud_rate);
 
                         if (result)
-                            demo_mode = false;
+                            add_device(std::move(source), comport_path);
                     }
+                    // print_out(std::string_view{"{}"}, result != 0 ? std::string_view{"success!"} :
+                    // std::string_view{"failed!"});
+                    fmt::format_to(std::back_inserter(cout_buffer), std::string_view{"{}"},
+                                   result != 0         ? std::string_view{"success!"}
+                                   : already_connected ? std::string_view{"already connected!"}
+                                                       : std::string_view{"failed!"});
                 }
 
+                // any other kind of source, file:<path>, stdin, tcp:<host>:<port>, udp:<host>:<port> or a port path
+                nk_layout_row_dynamic(ctx, 30, 4);
+                nk_label(ctx, "Source:", NK_TEXT_LEFT);
+                nk_edit_string(ctx, NK_EDIT_SIMPLE, source_spec, source_spec_len, (int)source_spec_sz - 1,
+                               nk_filter_default);
+
+                // picking a port fills in its path as the source
+                ports.poll();
+                if (port_names_generation != ports.generation()) {
+                    port_names.clear();
+                    for (const serial_port &port : ports.ports())
+                        port_names.emplace_back(port.name());
+                    port_names_generation = ports.generation();
+                    selected_port = 0;
+                }
+                if (port_names.size()) {
+                    int picked = nk_combo(ctx, port_names.data(), (int)port_names.size(), selected_port, 25,
+                                          nk_vec2(nk_widget_width(ctx), 200));
+                    if (picked != selected_port) {
+                        selected_port = picked;
+                        std::string_view path{ports.ports()[picked].path};
+                        std::memcpy(source_spec, path.data(), path.size());
+                        source_spec_len[0] = (int)path.size();
+                    }
+                } else {
+                    nk_label(ctx, "no ports", NK_TEXT_LEFT);
+                }
+                if (nk_button_label(ctx, "Open")) {
+                    std::string_view spec{source_spec, (size_t)source_spec_len[0]};
+                    fmt::format_to(std::back_inserter(cout_buffer), "opening {}...", spec);
+                    std::unique_ptr<data_source> source = open_source(spec, baud_rate);
+                    fmt::format_to(std::back_inserter(cout_buffer), std::string_view{"{}"},
+                                   source ? std::string_view{"success!"} : std::string_view{"failed!"});
+                    if (source)
+                        add_device(std::move(source), spec);
+                }
+
+                nk_layout_row_dynamic(ctx, 30, 4);
+                nk_property_int(ctx, "Max wait (ms)", 1, &latency_target_ms, 1000, 1, 1.0f);
+                for (size_t d = 0; d < devices.size(); d++)
+                    devices[d]->latency_target_ns.store(latency_target_ms * ns_per_ms, std::memory_order_relaxed);
+                // per graph, 0 keeps every sample in ram
+                nk_property_int(ctx, "RAM budget (MB)", 0, &ram_budget_mb, 1 << 16, 16, 1.0f);
+                set_ram_budget(local_stream, (size_t)ram_budget_mb * bytes_per_mb);
+                for (size_t d = 0; d < devices.size(); d++)
+                    devices[d]->ram_budget.store((size_t)ram_budget_mb * bytes_per_mb, std::memory_order_relaxed);
+
                 if (nk_tree_push_hashed(ctx, NK_TREE_TAB, "Gui", nk_collapse_states::NK_MINIMIZED, "_", 1, __LINE__)) {
                     nk_layout_row_dynamic(ctx, 30, 2);
                     
@@ -1248,38 +2027,91 @@ int main(int argc, char *argv[]) {
                 }
 
                 if (nk_tree_push_hashed(ctx, NK_TREE_TAB, "Data", nk_collapse_states::NK_MINIMIZED, "_", 1, __LINE__)) {
-                    nk_layout_row_dynamic(ctx, 30, 2);
+                    nk_layout_row_dynamic(ctx, 30, 3);
                     nk_label(ctx, "Data:", NK_TEXT_LEFT);
                     nk_checkbox_label(ctx, "Autoscroll", &data_auto_scroll);
+                    nk_property_int(ctx, "Source", 0, &data_source_index, (int)devices.size(), 1, 1.0f);
+                    data_source_index =
+                        data_source_index > (int)devices.size() ? (int)devices.size() : data_source_index;
 
-                    int len = 2048 < cout_buffer.size() ? 2048 : cout_buffer.size();
+                    std::unique_lock<std::mutex> log_lock;
+                    std::string &log = data_source_index ? devices[data_source_index - 1]->log : cout_buffer;
+                    if (data_source_index)
+                        log_lock = std::unique_lock<std::mutex>(devices[data_source_index - 1]->mutex);
+
+                    int len = 2048 < log.size() ? 2048 : log.size();
                     nk_layout_row_dynamic(ctx, 278, 1);
                     if (data_auto_scroll) {
                         nk_edit_focus(ctx, ctx->current->edit.mode);
                         // make sure we're absolutely going to scroll to the end
                         nk_scroll(ctx, (&ctx->style)->font->height * len);
                     }
-                    nk_edit_string(ctx, (NK_EDIT_BOX), (cout_buffer.data() + cout_buffer.size()) - len, &len, len,
-                                   nk_filter_default);
+                    nk_edit_string(ctx, (NK_EDIT_BOX), (log.data() + log.size()) - len, &len, len, nk_filter_default);
                     nk_tree_pop(ctx);
                 }
 
                 if (nk_tree_push_hashed(ctx, NK_TREE_TAB, "Input", nk_collapse_states::NK_MINIMIZED, "_", 1,
                                         __LINE__)) {
-                    nk_layout_row_dynamic(ctx, 30, 2);
+                    nk_layout_row_dynamic(ctx, 30, 4);
                     nk_label(ctx, "Data:", NK_TEXT_LEFT);
+                    nk_property_int(ctx, "Target", 0, &input_target, (int)devices.size(), 1, 1.0f);
+                    input_target = input_target > (int)devices.size() ? (int)devices.size() : input_target;
+                    nk_property_int(ctx, "Pacing (B/s)", 0, &tx_pacing, INT_MAX, 100, 10.0f);
+                    for (size_t d = 0; d < devices.size(); d++)
+                        devices[d]->tx.bytes_per_second.store((size_t)tx_pacing, std::memory_order_relaxed);
 
                     if (nk_button_label(ctx, "Send")) {
-                        // make sure we have padding for simdjson
-                        edit_string.reserve(edit_string.size() + (2 * SIMDJSON_PADDING));
-                        size_t g = handle_json(parser, ctx, graphs, edit_string.data(), edit_string.size());
+                        if (input_target) {
+                            // the device's writer takes it from here
+                            devices[input_target - 1]->tx.send(edit_string);
+                        } else {
+                            size_t g =
+                                handle_json(local_stream, cout_buffer, edit_string.data(), edit_string.size());
 
-                        graphs_to_display = (g > 0 && g != graphs_to_display) ? g : graphs_to_display;
+                            graphs_to_display = (g > 0 && g != graphs_to_display) ? g : graphs_to_display;
+                        }
 
                         edit_string.clear();
                         edit_count = 0;
                     }
 
+                    if (input_target) {
+                        tx_queue &tx = devices[input_target - 1]->tx;
+                        nk_layout_row_dynamic(ctx, 30, 5);
+                        char sent_text[64] = "sent: ";
+                        auto chrs = std::to_chars(sent_text + 6, sent_text + 63,
+                                                  tx.commands_sent.load(std::memory_order_relaxed));
+                        *chrs.ptr = 0;
+                        nk_label(ctx, sent_text, NK_TEXT_LEFT);
+
+                        char failed_text[64] = "failed: ";
+                        chrs = std::to_chars(failed_text + 8, failed_text + 63,
+                                             tx.failures.load(std::memory_order_relaxed));
+                        *chrs.ptr = 0;
+                        nk_label(ctx, failed_text, NK_TEXT_LEFT);
+
+                        char queued_text[64] = "queued (B): ";
+                        chrs = std::to_chars(queued_text + 12, queued_text + 63, tx.queued_bytes());
+                        *chrs.ptr = 0;
+                        nk_label(ctx, queued_text, NK_TEXT_LEFT);
+
+                        char last_text[64] = "latency (ms): ";
+                        chrs = std::to_chars(last_text + 14, last_text + 63,
+                                             (double)tx.last_latency_ns.load(std::memory_order_relaxed) /
+                                                 (double)ns_per_ms,
+                                             std::chars_format::fixed, 2);
+                        *chrs.ptr = 0;
+                        nk_label(ctx, last_text, NK_TEXT_LEFT);
+
+                        char max_text[64] = "max (ms): ";
+                        chrs = std::to_chars(max_text + 10, max_text + 63,
+                                             (double)tx.max_latency_ns.load(std::memory_order_relaxed) /
+                                                 (double)ns_per_ms,
+                                             std::chars_format::fixed, 2);
+                        *chrs.ptr = 0;
+                        nk_label(ctx, max_text, NK_TEXT_LEFT);
+                    }
+
                     nk_layout_row_dynamic(ctx, 278, 1);
 
                     // get the area for the next widget
@@ -1304,74 +2136,141 @@ int main(int argc, char *argv[]) {
 
                     nk_tree_pop(ctx);
                 }
-                nk_layout_row_dynamic(ctx, 30, 5);
+                nk_layout_row_dynamic(ctx, 30, 2);
                 char recieved[64] = "timestamp: ";
                 auto chrs = std::to_chars(recieved + 11, recieved + 64, last_ok_timestamp);
                 *chrs.ptr = 0;
                 nk_label(ctx, recieved, NK_TEXT_LEFT);
 
-                char recieved2[64] = "last: ";
-                chrs = std::to_chars(recieved2 + 6, recieved2 + 64, last_timestamp);
-                *chrs.ptr = 0;
-                nk_label(ctx, recieved2, NK_TEXT_LEFT);
-
-                char delay_text[64] = "delay (ms): ";
-                chrs = std::to_chars(delay_text + 12, delay_text + 64, delay / 1000000);
-                *chrs.ptr = 0;
-                nk_label(ctx, delay_text, NK_TEXT_LEFT);
-
-                char delay_text2[64] = "delay (ns): ";
-                chrs = std::to_chars(delay_text2 + 12, delay_text2 + 64, delay);
-                *chrs.ptr = 0;
-                nk_label(ctx, delay_text2, NK_TEXT_LEFT);
-
                 float fps = 1.0f / ((double)timestamp_diff / (double)ns_per_second);
                 char fps_text[64] = "fps: ";
                 chrs = std::to_chars(fps_text + 5, fps_text + 64, fps, std::chars_format::general, 3);
                 *chrs.ptr = 0;
                 nk_label(ctx, fps_text, NK_TEXT_LEFT);
 
+                for (size_t d = 0; d < devices.size(); d++) {
+                    device_t &device = *devices[d];
+                    size_t cadence = device.cadence_ns.load(std::memory_order_relaxed);
+
+                    nk_layout_row_dynamic(ctx, 30, 9);
+                    // the reader has stopped, the row and its data stay until it's disconnected
+                    if (device.reader.source_lost.load(std::memory_order_relaxed)) {
+                        char lost_text[128];
+                        *fmt::format_to_n(lost_text, sizeof(lost_text) - 1, "{} (lost)", device.path).out = 0;
+                        nk_label_colored(ctx, lost_text, NK_TEXT_LEFT, nk_rgb(255, 80, 80));
+                    } else {
+                        nk_label(ctx, device.path.c_str(), NK_TEXT_LEFT);
+                    }
+
+                    // the wait it's allowed next to the cadence it picked within it
+                    char wait_text[64] = "max wait (ms): ";
+                    chrs = std::to_chars(wait_text + 15, wait_text + 64,
+                                         device.latency_target_ns.load(std::memory_order_relaxed) / ns_per_ms);
+                    *chrs.ptr = 0;
+                    nk_label(ctx, wait_text, NK_TEXT_LEFT);
+
+                    char cadence_text[64] = "cadence (ms): ";
+                    chrs = std::to_chars(cadence_text + 14, cadence_text + 64, (double)cadence / (double)ns_per_ms,
+                                         std::chars_format::fixed, 2);
+                    *chrs.ptr = 0;
+                    nk_label(ctx, cadence_text, NK_TEXT_LEFT);
+
+                    char rate_text[64] = "rate (B/s): ";
+                    chrs = std::to_chars(rate_text + 12, rate_text + 64,
+                                         (size_t)device.arrival_rate.load(std::memory_order_relaxed));
+                    *chrs.ptr = 0;
+                    nk_label(ctx, rate_text, NK_TEXT_LEFT);
+
+                    char in_flight_text[64] = "in flight: ";
+                    chrs = std::to_chars(in_flight_text + 11, in_flight_text + 64, device.reader.bytes_in_flight());
+                    *chrs.ptr = 0;
+                    nk_label(ctx, in_flight_text, NK_TEXT_LEFT);
+
+                    char bytes_read_text[64] = "read: ";
+                    chrs = std::to_chars(bytes_read_text + 6, bytes_read_text + 64,
+                                         device.reader.bytes_read.load(std::memory_order_relaxed));
+                    *chrs.ptr = 0;
+                    nk_label(ctx, bytes_read_text, NK_TEXT_LEFT);
+
+                    char overruns_text[64] = "overruns: ";
+                    chrs = std::to_chars(overruns_text + 10, overruns_text + 64,
+                                         device.reader.overruns.load(std::memory_order_relaxed));
+                    *chrs.ptr = 0;
+                    nk_label(ctx, overruns_text, NK_TEXT_LEFT);
+
+                    char overrun_bytes_text[64] = "dropped: ";
+                    chrs = std::to_chars(overrun_bytes_text + 9, overrun_bytes_text + 64,
+                                         device.reader.overrun_bytes.load(std::memory_order_relaxed));
+                    *chrs.ptr = 0;
+                    nk_label(ctx, overrun_bytes_text, NK_TEXT_LEFT);
+
+                    bool disconnect = nk_button_label(ctx, "Disconnect");
+
+                    // where data was lost: on the line, in the driver, or in the parser
+                    line_errors line = device.source->LineErrors();
+                    size_t parser_dropped, resyncs, truncated, invalid_utf8;
+                    {
+                        std::lock_guard<std::mutex> lock(device.mutex);
+                        parser_dropped = device.stream.dropped_bytes;
+                        resyncs = device.stream.resyncs;
+                        truncated = device.stream.truncated_objects;
+                        invalid_utf8 = device.stream.invalid_utf8_bytes;
+                    }
+                    auto stat_label = [ctx](std::string_view name, size_t value) {
+                        char text[64];
+                        std::memcpy(text, name.data(), name.size());
+                        auto chrs = std::to_chars(text + name.size(), text + sizeof(text) - 1, value);
+                        *chrs.ptr = 0;
+                        nk_label(ctx, text, NK_TEXT_LEFT);
+                    };
+                    nk_layout_row_dynamic(ctx, 30, 9);
+                    stat_label("bad utf-8: ", invalid_utf8);
+                    stat_label("uart overruns: ", line.overruns);
+                    stat_label("driver overruns: ", line.buffer_overruns);
+                    stat_label("framing: ", line.framing);
+                    stat_label("parity: ", line.parity);
+                    stat_label("breaks: ", line.breaks);
+                    stat_label("parse dropped: ", parser_dropped);
+                    stat_label("resyncs: ", resyncs);
+                    stat_label("truncated: ", truncated);
+
+                    if (disconnect) {
+                        devices.erase(devices.begin() + d);
+                        d--;
+                    }
+                }
+
                 nk_tree_pop(ctx);
             }
 
             /* COM GUI */
             bg.r = 0.10f, bg.g = 0.18f, bg.b = 0.24f, bg.a = 1.0f;
 
-            // 1'000'000'000 ns => 1 second
-            size_t timestamp_diff = (current_timestamp - last_timestamp);
-            if (SerialPort.IsConnected() && (timestamp_diff > delay)) {
-                /* Serial Stuff */
-                last_timestamp = current_timestamp;
-                read_count = SerialPort.ReadData(ptr, (mx_width - (2 * SIMDJSON_PADDING)));
-                ptr[read_count] = 0;
-
-                if (read_count > 0) { // -1 is failure so check > 0
-                    size_t g = handle_json(parser, ctx, graphs, ptr, read_count);
-                    graphs_to_display = (g > 0 && g != graphs_to_display) ? g : graphs_to_display;
-                }
-            } else if (demo_mode && example_json_mode) {
+            // devices are read and parsed on their own threads, only the demo feeds us here
+            if (demo_mode && example_json_mode) {
                 /* Parsing Json Data */
-                size_t g = handle_json(parser, ctx, graphs, mangled_example_json.data(), mangled_example_json.size());
+                size_t g =
+                    handle_json(local_stream, cout_buffer, mangled_example_json.data(), mangled_example_json.size());
                 graphs_to_display = (g > 0 && g != graphs_to_display) ? g : graphs_to_display;
                 last_ok_timestamp = current_timestamp;
-                float flt_ts = current_timestamp / 1000000.0f;
+                const double timestamp = current_timestamp / 1'000'000.0;
                 for (size_t i = 0; i < graphs_to_display; i++) {
-                    for (size_t s = 0; s < graphs[i].values.size(); s++) {
-                        graphs[i].values[s].back().x = flt_ts;
-                    }
+                    if (graphs[i].samples.rows())
+                        graphs[i].samples.timestamps.set_back(timestamp);
                 }
             } else if (demo_mode) {
                 /* Randomly Generated Data */
                 last_ok_timestamp = current_timestamp;
                 graphs_to_display = 6;
-                float flt_ts = current_timestamp / 1000000.0f;
+                const double timestamp = current_timestamp / 1'000'000.0;
                 for (size_t i = 0; i < graphs_to_display; i++) {
                     if (i >= graphs.size()) {
                         graphs.emplace_back();
                     }
                     // number of data points to show
-                    graphs[i].limit = 60;
+                    set_limit(local_stream, graphs[i], 60);
                     graphs[i].slots = 2;
+                    graphs[i].schema = 0;
                     if (graphs[i].title.empty()) {
                         graphs[i].title.clear();
                         fmt::format_to(std::back_inserter(graphs[i].title), "graph #{}", i);
@@ -1387,73 +2286,40 @@ int main(int argc, char *argv[]) {
                             s++;
                         }
                     }
-                    graphs[i].values.reserve(graphs[i].colors.size());
+                    graphs[i].samples.values.reserve(graphs[i].colors.size());
                     graphs[i].labels.reserve(graphs[i].colors.size());
                     // make sure we have enough graphs for all the colors
 
-                    while (graphs[i].values.size() < graphs[i].colors.size()) {
-                        graphs[i].values.emplace_back();
+                    while (graphs[i].samples.slots() < graphs[i].colors.size()) {
+                        graphs[i].samples.add_slot();
                         graphs[i].labels.emplace_back();
                     }
 
-                    // reserve to the limit
-                    for (size_t s = 0; s < graphs[i].values.size(); s++) {
+                    for (size_t s = 0; s < graphs[i].samples.slots(); s++) {
                         if (graphs[i].labels[s].empty()) {
                             graphs[i].labels[s].clear();
                             fmt::format_to(std::back_inserter(graphs[i].labels[s]), "data #{}", s);
                         }
-
-                        if (graphs[i].values[s].capacity() < (graphs[i].limit + 1))
-                            graphs[i].values[s].reserve(graphs[i].limit + 1);
-
-                        for (size_t l = graphs[i].values[s].size(); l < graphs[i].limit; l++) {
-#if __clang__
-                            // graphs[i].values[s].emplace_back();
-#else
-                            if (graphs[i].values[s].size() < 1)
-                                graphs[i].values[s].emplace_back(0.0f, 0.0f);
-                            else
-                                graphs[i].values[s].emplace_back(graphs[i].values[s].back().x + 0.001f,
-                                                                 graphs[i].values[s].back().y +
-                                                                     ((pcg32_random_r(&rng) % 256) / 1024.0f) -
-                                                                     (128 / 1024.0f));
-#endif
-                        }
                     }
 
-                    for (size_t s = 0; s < graphs[i].values.size(); s++) {
-                        // fill with data point
-                        auto it = graphs[i].values[s].end();
-                        float rnd_value = ((pcg32_random_r(&rng) % 256) / 1024.0f) - (128 / 1024.0f);
-                        struct nk_vec2 &point = graphs[i].values[s].unchecked_emplace_back();
-                        point.y = it->y + rnd_value;
-                        point.x = flt_ts;
-
-                        if (graphs[i].values[s].size() > graphs[i].limit) {
-                            graphs[i].values[s].erase(graphs[i].values[s].begin());
+                    // a random walk for every slot, a full ring drops the oldest row
+                    sample_columns &samples = graphs[i].samples;
+                    auto step = [&](double row_timestamp) {
+                        samples.push_row(row_timestamp);
+                        const size_t rows = samples.rows();
+                        for (size_t s = 0; s < samples.slots(); s++) {
+                            float last = rows > 1 ? samples.values[s][rows - 2] : 0.0f;
+                            last = is_missing(last) ? 0.0f : last;
+                            samples.set(s, last + ((pcg32_random_r(&rng) % 256) / 1024.0f) - (128 / 1024.0f));
                         }
-                        /* //if using std::vector
-                        #if __clang__
-                                                struct nk_vec2 &vec = graphs[i].values[s].emplace_back();
-                                                if (graphs[i].values[s].size()) {
-                                                    vec.x = flt_ts;
-                                                    vec.y = graphs[i].values[s][graphs[i].values[s].size() - 1].y +
-                                                            ((pcg32_random_r(&rng) % 256) / 1024.0f) - (128 / 1024.0f);
-                                                }
-                                                if (graphs[i].values[s].size() > graphs[i].limit) {
-                                                    graphs[i].values[s].erase(graphs[i].values[s].begin());
-                                                }
-                        #else
-                                                if (graphs[i].values[s].size() < 1)
-                                                    graphs[i].values[s].emplace_back(flt_ts, 0.0f);
-                                                graphs[i].values[s].emplace_back(flt_ts, graphs[i].values[s].back().y +
-                                                                                             ((pcg32_random_r(&rng) %
-                        256) / 1024.0f) - (128 / 1024.0f)); if (graphs[i].values[s].size() > graphs[i].limit) {
-                                                    graphs[i].values[s].erase(graphs[i].values[s].begin());
-                                                }
-                        #endif
-                        */
-                    }
+                    };
+                    // fill up to the limit
+                    if (!samples.rows())
+                        step(0.0);
+                    while (samples.rows() < graphs[i].limit)
+                        step(samples.timestamps.back() + 0.001);
+                    // fill with data point
+                    step(timestamp);
                 }
             }
 
@@ -1463,224 +2329,309 @@ int main(int argc, char *argv[]) {
             /* Dynamic render to fit graphs */
             nk_layout_row_dynamic(ctx, graph_height, (content_region.w / graph_width));
 
-            for (size_t i = 0; i < graphs.size() && i < graphs_to_display; i++) {
-                float min_value;
-                float max_value;
-                float min_ts;
-                float max_ts;
-                size_t offset = 0;
-
-                if (graphs[i].values.size()) {
-                    // figure out the ranges the data fills
-                    min_ts = graphs[i].values[0][offset].x;
-                    max_ts = graphs[i].values[0][offset].x;
-                    min_value = graphs[i].values[0][offset].y;
-                    max_value = graphs[i].values[0][offset].y;
-                    for (size_t s = 0; s < graphs[i].values.size() && s < graphs[i].slots; s++) {
-                        for (size_t idx = offset; idx < graphs[i].values[s].size(); idx++) {
-                            min_ts = NK_MIN(graphs[i].values[s][idx].x, min_ts);
-                            max_ts = NK_MAX(graphs[i].values[s][idx].x, max_ts);
-                            min_value = NK_MIN(graphs[i].values[s][idx].y, min_value);
-                            max_value = NK_MAX(graphs[i].values[s][idx].y, max_value);
+            // our own graphs first, then each device's under its lock so its worker can't write mid-draw
+            for (size_t source = 0; source <= devices.size(); source++) {
+                std::unique_lock<std::mutex> graphs_lock;
+                if (source)
+                    graphs_lock = std::unique_lock<std::mutex>(devices[source - 1]->mutex);
+                real::vector<graph_t> &graphs = source ? devices[source - 1]->stream.graphs : local_stream.graphs;
+                size_t source_graphs = source ? devices[source - 1]->graphs_to_display : graphs_to_display;
+                std::string_view source_name = source ? std::string_view{devices[source - 1]->path} : std::string_view{};
+
+                for (size_t i = 0; i < graphs.size() && i < source_graphs; i++) {
+                    float min_value;
+                    float max_value;
+                    // doubles, a float can't tell hours of millisecond timestamps apart
+                    double min_ts;
+                    double max_ts;
+
+                    const sample_columns &samples = graphs[i].samples;
+                    if (samples.rows()) {
+                        // figure out the ranges the data fills, each column keeps track of its own so it's O(slots)
+                        const basic_value_range<double> ts = samples.timestamps.extents();
+                        min_ts = ts.lo;
+                        max_ts = ts.hi;
+                        value_range y;
+                        for (size_t s = 0; s < samples.slots() && s < graphs[i].slots; s++)
+                            y.add(samples.values[s].extents());
+                        // nothing but gaps
+                        if (y.empty()) {
+                            y.lo = 0.0f;
+                            y.hi = 0.0f;
                         }
-                    }
-                    // widen the view if somehow the data's perfectly flat
-                    if (min_value == max_value) {
-                        max_value = min_value + 1.0f;
-                        graphs[i].upper_value.value = max_value;
-                        graphs[i].lower_value.value = min_value;
-                    }
-                    if (min_ts == max_ts) {
-                        max_ts = min_ts + 1.0f;
-                    }
-
-                    char hi_buffer[64];
-                    auto num = std::to_chars(hi_buffer, hi_buffer + 64, max_value);
-                    *num.ptr = 0;
-                    char lo_buffer[64];
-                    auto num2 = std::to_chars(lo_buffer, lo_buffer + 64, min_value);
-                    *num2.ptr = 0;
-
-                    {
-                        struct nk_window *win;
-                        struct nk_chart *chart;
-                        const struct nk_style *config;
-                        const struct nk_style_chart *style;
-
-                        const struct nk_style_item *background;
-
-                        // struct nk_rect widget_bounds = nk_widget_bounds(ctx);
-                        struct nk_rect widget_bounds;
-                        // reserve space for our graph
-                        if (!ctx || !ctx->current || !ctx->current->layout) {
-                            continue;
+                        min_value = y.lo;
+                        max_value = y.hi;
+                        // widen the view if somehow the data's perfectly flat
+                        if (min_value == max_value) {
+                            max_value = min_value + 1.0f;
+                            graphs[i].upper_value.value = max_value;
+                            graphs[i].lower_value.value = min_value;
                         }
-                        if (!nk_widget(&widget_bounds, ctx)) {
-                            continue;
+                        if (min_ts == max_ts) {
+                            max_ts = min_ts + 1.0;
                         }
 
-                        win = ctx->current;
-                        config = &ctx->style;
-                        chart = &win->layout->chart;
-                        style = &config->chart;
-                        background = &style->background;
-
-                        struct nk_rect graph_bounds;
-                        graph_bounds.x = widget_bounds.x + style->padding.x;
-                        graph_bounds.y = widget_bounds.y + style->padding.y;
-                        graph_bounds.w = widget_bounds.w - 2 * style->padding.x;
-                        graph_bounds.h = widget_bounds.h - 2 * style->padding.y;
-                        graph_bounds.w = NK_MAX(graph_bounds.w, 2 * style->padding.x);
-                        graph_bounds.h = NK_MAX(graph_bounds.h, 2 * style->padding.y);
-
-                        // draw our background
-                        if (background->type == NK_STYLE_ITEM_IMAGE) {
-                            nk_draw_image(&win->buffer, widget_bounds, &background->data.image, nk_white);
-                        } else {
-                            nk_fill_rect(&win->buffer, widget_bounds, style->rounding, style->border_color);
-                            nk_fill_rect(&win->buffer, nk_shrink_rect(widget_bounds, style->border), style->rounding,
-                                         style->background.data.color);
-                        }
+                        char hi_buffer[64];
+                        auto num = std::to_chars(hi_buffer, hi_buffer + 64, max_value);
+                        *num.ptr = 0;
+                        char lo_buffer[64];
+                        auto num2 = std::to_chars(lo_buffer, lo_buffer + 64, min_value);
+                        *num2.ptr = 0;
+
+                        {
+                            struct nk_window *win;
+                            struct nk_chart *chart;
+                            const struct nk_style *config;
+                            const struct nk_style_chart *style;
+
+                            const struct nk_style_item *background;
+
+                            // struct nk_rect widget_bounds = nk_widget_bounds(ctx);
+                            struct nk_rect widget_bounds;
+                            // reserve space for our graph
+                            if (!ctx || !ctx->current || !ctx->current->layout) {
+                                continue;
+                            }
+                            if (!nk_widget(&widget_bounds, ctx)) {
+                                continue;
+                            }
 
-                        // draw our lines
-                        size_t point_idx = 0;
-                        // we clear here so reserve doesn't copy what should be an empty buffer
-                        graphs[i].points.clear();
-                        size_t coordinates = 0;
-                        for (size_t s = 0; s < graphs[i].values.size(); s++)
-                            coordinates += graphs[i].values[s].size();
-                        if (coordinates > graphs[i].points.capacity())
-                            graphs[i].points.reserve(coordinates * 4);
-                        // graphs[i].points.reserve(graphs[i].limit * graphs[i].values.size());
-                        float *data = graphs[i].points.data();
-
-                        float xrange = max_ts - min_ts;
-                        float yrange = max_value - min_value;
-                        // make this an option
-                        graphs[i].upper_value.lerp_v = zoom_rate;
-                        graphs[i].lower_value.lerp_v = zoom_rate;
-                        // make 0.05 an option
-                        float yupper = graphs[i].upper_value.get_next_smooth_upper(max_value + (zoom_factor * yrange));
-                        float ylower = graphs[i].lower_value.get_next_smooth_lower(min_value - (zoom_factor * yrange));
-
-                        float x_range = max_ts - min_ts;
-                        float y_range = yupper - ylower;
-                        // float y_range = max_value - min_value;
-
-                        float ylimrange = yupper - ylower;
-                        float yspacing = ylimrange / (float)(yticks + 1);
-                        // float yoffset = yspacing / 2.0f;
-                        // float xstep = graph_bounds.w / graphs[i].limit;
-
-                        for (size_t s = 0; s < graphs[i].values.size() && s < graphs[i].slots; s++) {
-                            float *line_data = data + point_idx;
-                            //
-
-                            for (size_t idx = 0; idx < graphs[i].values[s].size(); idx++) {
-                                line_data[idx * 2] =
-                                    widget_bounds.x + (widget_bounds.w * ((graphs[i].values[s][idx].x - min_ts) /
-                                                                          x_range)); // std::lerp(0.0f, x_range, );
-                                line_data[(idx * 2) + 1] =
-                                    (widget_bounds.y + widget_bounds.h) -
-                                    (((graphs[i].values[s][idx].y - ylower) / ylimrange) * widget_bounds.h);
-
-                                point_idx += 2;
+                            win = ctx->current;
+                            config = &ctx->style;
+                            chart = &win->layout->chart;
+                            style = &config->chart;
+                            background = &style->background;
+
+                            struct nk_rect graph_bounds;
+                            graph_bounds.x = widget_bounds.x + style->padding.x;
+                            graph_bounds.y = widget_bounds.y + style->padding.y;
+                            graph_bounds.w = widget_bounds.w - 2 * style->padding.x;
+                            graph_bounds.h = widget_bounds.h - 2 * style->padding.y;
+                            graph_bounds.w = NK_MAX(graph_bounds.w, 2 * style->padding.x);
+                            graph_bounds.h = NK_MAX(graph_bounds.h, 2 * style->padding.y);
+
+                            // draw our background
+                            if (background->type == NK_STYLE_ITEM_IMAGE) {
+                                nk_draw_image(&win->buffer, widget_bounds, &background->data.image, nk_white);
+                            } else {
+                                nk_fill_rect(&win->buffer, widget_bounds, style->rounding, style->border_color);
+                                nk_fill_rect(&win->buffer, nk_shrink_rect(widget_bounds, style->border), style->rounding,
+                                             style->background.data.color);
                             }
-                            nk_stroke_polyline_float(&ctx->current->buffer, line_data, graphs[i].values[s].size(),
-                                                     line_width, graphs[i].colors[s]);
 
-                            // struct nk_handle h;
-                            // h.ptr = &graphs[i].lin
-                            // nk_push_custom(&ctx->current->buffer, graph_bounds, render_polyline, );
-                            struct nk_vec2 item_padding;
-                            struct nk_text slot_text;
-                            item_padding = (&ctx->style)->text.padding;
+                            // draw our lines
+                            size_t point_idx = 0;
+                            // we clear here so reserve doesn't copy what should be an empty buffer
+                            graphs[i].points.clear();
+                            // past two rows a pixel each pixel gets the min and max of its rows from the pyramids
+                            // instead, drawing costs O(pixels log n) however long the history is
+                            const size_t pixels = widget_bounds.w > 1.0f ? (size_t)widget_bounds.w : 1;
+                            const bool decimate = samples.rows() > pixels * 2;
+                            // an x and a y for every point
+                            const size_t floats = (decimate ? pixels * 2 : samples.rows()) * samples.slots() * 2;
+                            if (floats > graphs[i].points.capacity())
+                                graphs[i].points.reserve(floats * 2);
+                            float *data = graphs[i].points.data();
+
+                            float yrange = max_value - min_value;
+                            // make this an option
+                            graphs[i].upper_value.lerp_v = zoom_rate;
+                            graphs[i].lower_value.lerp_v = zoom_rate;
+                            // make 0.05 an option
+                            float yupper = graphs[i].upper_value.get_next_smooth_upper(max_value + (zoom_factor * yrange));
+                            float ylower = graphs[i].lower_value.get_next_smooth_lower(min_value - (zoom_factor * yrange));
+
+                            const double x_range = max_ts - min_ts;
+                            float y_range = yupper - ylower;
+                            // float y_range = max_value - min_value;
+
+                            float ylimrange = yupper - ylower;
+                            float yspacing = ylimrange / (float)(yticks + 1);
+                            // float yoffset = yspacing / 2.0f;
+                            // float xstep = graph_bounds.w / graphs[i].limit;
+
+                            const double x_scale = widget_bounds.w / x_range;
+                            const float y_scale = widget_bounds.h / ylimrange;
+                            const float y_bottom = widget_bounds.y + widget_bounds.h;
+                            for (size_t s = 0; s < samples.slots() && s < graphs[i].slots; s++) {
+                                float *line_data = data + point_idx;
+                                size_t line_points = 0;
+                                auto stroke = [&]() {
+                                    if (line_points > 1)
+                                        nk_stroke_polyline_float(&ctx->current->buffer, line_data, line_points,
+                                                                 line_width, graphs[i].colors[s]);
+                                    line_data += line_points * 2;
+                                    line_points = 0;
+                                };
+                                // x relative to min_ts in double before it's narrowed to a screen coordinate
+                                auto add_point = [&](double x, float y) {
+                                    line_data[line_points * 2] = widget_bounds.x + (float)((x - min_ts) * x_scale);
+                                    line_data[(line_points * 2) + 1] = y_bottom - (y - ylower) * y_scale;
+                                    line_points++;
+                                    point_idx += 2;
+                                };
 
-                            slot_text.padding.x = item_padding.x;
-                            slot_text.padding.y = item_padding.y;
-                            slot_text.background = (&ctx->style)->window.background;
-                            slot_text.text = graphs[i].colors[s];
-                            // chart.slots[slot].color;
-                            // slot title
-                            struct nk_rect slot_bounds;
-                            slot_bounds = graph_bounds;
+                                // a missing value ends one line and the next value starts another
+                                if (decimate) {
+                                    const sample_column &column = samples.values[s];
+                                    for (size_t p = 0; p < pixels; p++) {
+                                        const size_t first = samples.rows() * p / pixels;
+                                        const size_t last = samples.rows() * (p + 1) / pixels;
+                                        const value_range range = column.extents(first, last - first);
+                                        if (range.empty()) {
+                                            stroke();
+                                            continue;
+                                        }
+                                        // low then high or the other way around, whichever the rows start closer to
+                                        const float start = column[first];
+                                        const bool high_first =
+                                            !is_missing(start) && start - range.lo > range.hi - start;
+                                        add_point(samples.timestamps[first], high_first ? range.hi : range.lo);
+                                        add_point(samples.timestamps[last - 1], high_first ? range.lo : range.hi);
+                                    }
+                                } else {
+                                    // oldest to newest, at most two rows a pixel so going by row is cheap, and the
+                                    // older rows may be spilled while the newer ones are in ram
+                                    const sample_column &column = samples.values[s];
+                                    for (size_t r = 0; r < samples.rows(); r++) {
+                                        const float y = column[r];
+                                        if (is_missing(y)) {
+                                            stroke();
+                                            continue;
+                                        }
+                                        add_point(samples.timestamps[r], y);
+                                    }
+                                }
+                                stroke();
+
+                                // struct nk_handle h;
+                                // h.ptr = &graphs[i].lin
+                                // nk_push_custom(&ctx->current->buffer, graph_bounds, render_polyline, );
+                                struct nk_vec2 item_padding;
+                                struct nk_text slot_text;
+                                item_padding = (&ctx->style)->text.padding;
+
+                                slot_text.padding.x = item_padding.x;
+                                slot_text.padding.y = item_padding.y;
+                                slot_text.background = (&ctx->style)->window.background;
+                                slot_text.text = graphs[i].colors[s];
+                                // chart.slots[slot].color;
+                                // slot title
+                                struct nk_rect slot_bounds;
+                                slot_bounds = graph_bounds;
+
+                                slot_bounds.y += (((&ctx->style)->font->height + 2.0f) * (s + 2));
+                                slot_bounds.h -= 2 * (((&ctx->style)->font->height + 2.0f) * (s + 2));
+
+                                slot_bounds.x += 2 * (graph_bounds.w / graphs[i].limit);
+                                slot_bounds.w -= 4 * (graph_bounds.w / graphs[i].limit);
+
+                                nk_widget_text(&ctx->current->buffer, slot_bounds, graphs[i].labels[s].c_str(),
+                                               graphs[i].labels[s].size(), &slot_text, NK_TEXT_ALIGN_RIGHT,
+                                               (&ctx->style)->font);
+                            }
+                            // use these uv functions b/c otherwise the coordinates can do a little dance
+                            // draw ticks along vertical axis
+                            float ydiv = 1.0f / (float)(yticks + 1);
+                            for (size_t t = 0; t < yticks; t++) {
+                                nk_chart_draw_line_uv(ctx, graph_bounds, (ydiv * (t + 1)), 10.0f, 2.0f,
+                                                      nk_color{255, 255, 255, 255}, NK_TEXT_ALIGN_LEFT);
+                                nk_chart_draw_value_uv(ctx, graph_bounds, ylower, yupper, (ydiv * (t + 1)), 10.0f, 2.0f,
+                                                       nk_color{255, 255, 255, 255}, NK_TEXT_ALIGN_LEFT,
+                                                       NK_TEXT_ALIGN_MIDDLE | NK_TEXT_ALIGN_LEFT);
+                            }
 
-                            slot_bounds.y += (((&ctx->style)->font->height + 2.0f) * (s + 2));
-                            slot_bounds.h -= 2 * (((&ctx->style)->font->height + 2.0f) * (s + 2));
+                            // draw ticks along horizontal axis
+                            float xdiv = 1.0f / (float)(xticks + 1);
+                            for (size_t t = 0; t < xticks; t++) {
+                                nk_chart_draw_line_uv(ctx, graph_bounds, xdiv * (t + 1), 10.0f, 2.0f,
+                                                      nk_color{255, 255, 255, 255}, NK_TEXT_ALIGN_BOTTOM);
 
-                            slot_bounds.x += 2 * (graph_bounds.w / graphs[i].limit);
-                            slot_bounds.w -= 4 * (graph_bounds.w / graphs[i].limit);
+                                nk_chart_draw_value_uv(ctx, graph_bounds, min_ts, max_ts, xdiv * (t + 1), 10.0f, 2.0f,
+                                                       nk_color{255, 255, 255, 255}, NK_TEXT_ALIGN_BOTTOM,
+                                                       NK_TEXT_ALIGN_BOTTOM | NK_TEXT_ALIGN_CENTERED);
+                            }
 
-                            nk_widget_text(&ctx->current->buffer, slot_bounds, graphs[i].labels[s].c_str(),
-                                           graphs[i].labels[s].size(), &slot_text, NK_TEXT_ALIGN_RIGHT,
-                                           (&ctx->style)->font);
-                        }
-                        // use these uv functions b/c otherwise the coordinates can do a little dance
-                        // draw ticks along vertical axis
-                        float ydiv = 1.0f / (float)(yticks + 1);
-                        for (size_t t = 0; t < yticks; t++) {
-                            nk_chart_draw_line_uv(ctx, graph_bounds, (ydiv * (t + 1)), 10.0f, 2.0f,
-                                                  nk_color{255, 255, 255, 255}, NK_TEXT_ALIGN_LEFT);
-                            nk_chart_draw_value_uv(ctx, graph_bounds, ylower, yupper, (ydiv * (t + 1)), 10.0f, 2.0f,
-                                                   nk_color{255, 255, 255, 255}, NK_TEXT_ALIGN_LEFT,
-                                                   NK_TEXT_ALIGN_MIDDLE | NK_TEXT_ALIGN_LEFT);
-                        }
+                            // Draw the title top centered
+                            struct nk_text text_opts;
+                            struct nk_vec2 item_padding;
+                            item_padding = (&ctx->style)->text.padding;
+                            // text settings
+                            text_opts.padding.x = item_padding.x;
+                            text_opts.padding.y = item_padding.y;
+                            text_opts.background = (&ctx->style)->window.background;
+                            text_opts.text = nk_color{255, 255, 255, 255}; // ctx->style.text.color;
+
+                            // prefix with the device so boards sending the same titles stay apart
+                            graph_title.clear();
+                            if (source_name.size())
+                                fmt::format_to(std::back_inserter(graph_title), "{}: ", source_name);
+                            graph_title.append(graphs[i].title);
+                            nk_widget_text(&ctx->current->buffer, graph_bounds, graph_title.data(), graph_title.size(),
+                                           &text_opts, NK_TEXT_ALIGN_CENTERED | NK_TEXT_ALIGN_TOP, ctx->style.font);
+
+                            // handle some user interfacing
+                            // nk_flags ret;
+                            // size_t hover_point;
+                            if (!(ctx->current->layout->flags & NK_WINDOW_ROM)) {
+                                // check if we're in bounds of a point
+                                /*
+                                for (size_t p = 0; p < point_idx; p += 2) {
+                                    struct nk_rect point_of_interest;
+                                    point_of_interest.x = data[p] - 2;
+                                    point_of_interest.y = data[p + 1] - 2;
+                                    point_of_interest.w = 6;
+                                    point_of_interest.h = 6;
+
+                                    ret = nk_input_is_mouse_hovering_rect(&ctx->input, point_of_interest);
+                                    if (ret) {
+                                        ret = NK_CHART_HOVERING;
+                                        ret |= ((&ctx->input)->mouse.buttons[NK_BUTTON_LEFT].down &&
+                                                (&ctx->input)->mouse.buttons[NK_BUTTON_LEFT].clicked)
+                                                   ? NK_CHART_CLICKED
+                                                   : 0;
+                                    } else {
+                                        continue;
+                                    }
 
-                        // draw ticks along horizontal axis
-                        float xdiv = 1.0f / (float)(xticks + 1);
-                        for (size_t t = 0; t < xticks; t++) {
-                            nk_chart_draw_line_uv(ctx, graph_bounds, xdiv * (t + 1), 10.0f, 2.0f,
-                                                  nk_color{255, 255, 255, 255}, NK_TEXT_ALIGN_BOTTOM);
+                                    if (ret & NK_CHART_HOVERING) {
+                                        // do something when hoving over a point (show its x, y coordinate)
+                                        char text[64];
+                                        auto xchrs = std::to_chars(text, text + 64, data[p]);
+                                        *xchrs.ptr = ',';
+                                        auto chrs = std::to_chars(xchrs.ptr + 1, text + 64, data[p + 1]);
+                                        size_t text_len = chrs.ptr - text;
 
-                            nk_chart_draw_value_uv(ctx, graph_bounds, min_ts, max_ts, xdiv * (t + 1), 10.0f, 2.0f,
-                                                   nk_color{255, 255, 255, 255}, NK_TEXT_ALIGN_BOTTOM,
-                                                   NK_TEXT_ALIGN_BOTTOM | NK_TEXT_ALIGN_CENTERED);
-                        }
+                                        const struct nk_style *style = &ctx->style;
+                                        struct nk_vec2 padding = style->window.padding;
 
-                        // Draw the title top centered
-                        struct nk_text text_opts;
-                        struct nk_vec2 item_padding;
-                        item_padding = (&ctx->style)->text.padding;
-                        // text settings
-                        text_opts.padding.x = item_padding.x;
-                        text_opts.padding.y = item_padding.y;
-                        text_opts.background = (&ctx->style)->window.background;
-                        text_opts.text = nk_color{255, 255, 255, 255}; // ctx->style.text.color;
-
-                        nk_widget_text(&ctx->current->buffer, graph_bounds, graphs[i].title.data(),
-                                       graphs[i].title.size(), &text_opts, NK_TEXT_ALIGN_CENTERED | NK_TEXT_ALIGN_TOP,
-                                       ctx->style.font);
-
-                        // handle some user interfacing
-                        // nk_flags ret;
-                        // size_t hover_point;
-                        if (!(ctx->current->layout->flags & NK_WINDOW_ROM)) {
-                            // check if we're in bounds of a point
-                            /*
-                            for (size_t p = 0; p < point_idx; p += 2) {
-                                struct nk_rect point_of_interest;
-                                point_of_interest.x = data[p] - 2;
-                                point_of_interest.y = data[p + 1] - 2;
-                                point_of_interest.w = 6;
-                                point_of_interest.h = 6;
-
-                                ret = nk_input_is_mouse_hovering_rect(&ctx->input, point_of_interest);
-                                if (ret) {
-                                    ret = NK_CHART_HOVERING;
-                                    ret |= ((&ctx->input)->mouse.buttons[NK_BUTTON_LEFT].down &&
-                                            (&ctx->input)->mouse.buttons[NK_BUTTON_LEFT].clicked)
-                                               ? NK_CHART_CLICKED
-                                               : 0;
-                                } else {
-                                    continue;
+                                        float text_width =
+                                            style->font->width(style->font->userdata, style->font->height, text, text_len);
+                                        text_width += (4 * padding.x);
+
+                                        float text_height = (style->font->height + 2 * padding.y);
+
+                                        if (nk_tooltip_begin(ctx, (float)text_width)) {
+                                            nk_layout_row_dynamic(ctx, (float)text_height, 1);
+                                            nk_text(ctx, text, text_len, NK_TEXT_LEFT);
+                                            nk_tooltip_end(ctx);
+                                        }
+                                    }
                                 }
+                                */
+                                if (nk_input_is_mouse_hovering_rect(&ctx->input, graph_bounds) &&
+                                    (&ctx->input)->mouse.buttons[NK_BUTTON_LEFT].down) {
 
-                                if (ret & NK_CHART_HOVERING) {
-                                    // do something when hoving over a point (show its x, y coordinate)
                                     char text[64];
-                                    auto xchrs = std::to_chars(text, text + 64, data[p]);
+                                    double xval = std::lerp(
+                                        min_ts, max_ts,
+                                        (double)(((&ctx->input)->mouse.pos.x - graph_bounds.x) / graph_bounds.w));
+                                    auto xchrs = std::to_chars(text, text + 64, xval);
                                     *xchrs.ptr = ',';
-                                    auto chrs = std::to_chars(xchrs.ptr + 1, text + 64, data[p + 1]);
+
+                                    float yval = std::lerp(
+                                        yupper, ylower, (((&ctx->input)->mouse.pos.y - graph_bounds.y) / graph_bounds.h));
+                                    auto chrs = std::to_chars(xchrs.ptr + 1, text + 64, yval);
                                     size_t text_len = chrs.ptr - text;
 
                                     const struct nk_style *style = &ctx->style;
@@ -1698,47 +2649,17 @@ int main(int argc, char *argv[]) {
                                         nk_tooltip_end(ctx);
                                     }
                                 }
-                            }
-                            */
-                            if (nk_input_is_mouse_hovering_rect(&ctx->input, graph_bounds) &&
-                                (&ctx->input)->mouse.buttons[NK_BUTTON_LEFT].down) {
-
-                                char text[64];
-                                float xval = std::lerp(
-                                    min_ts, max_ts, (((&ctx->input)->mouse.pos.x - graph_bounds.x) / graph_bounds.w));
-                                auto xchrs = std::to_chars(text, text + 64, xval);
-                                *xchrs.ptr = ',';
-
-                                float yval = std::lerp(
-                                    yupper, ylower, (((&ctx->input)->mouse.pos.y - graph_bounds.y) / graph_bounds.h));
-                                auto chrs = std::to_chars(xchrs.ptr + 1, text + 64, yval);
-                                size_t text_len = chrs.ptr - text;
-
-                                const struct nk_style *style = &ctx->style;
-                                struct nk_vec2 padding = style->window.padding;
-
-                                float text_width =
-                                    style->font->width(style->font->userdata, style->font->height, text, text_len);
-                                text_width += (4 * padding.x);
-
-                                float text_height = (style->font->height + 2 * padding.y);
-
-                                if (nk_tooltip_begin(ctx, (float)text_width)) {
-                                    nk_layout_row_dynamic(ctx, (float)text_height, 1);
-                                    nk_text(ctx, text, text_len, NK_TEXT_LEFT);
-                                    nk_tooltip_end(ctx);
+                                if (nk_input_is_mouse_hovering_rect(&ctx->input, graph_bounds) &&
+                                    (&ctx->input)->keyboard.keys[NK_KEY_COPY].down &&
+                                    (&ctx->input)->keyboard.keys[NK_KEY_COPY].clicked) {
+                                    /*
+                                    cout_buffer = graphs_to_string(graphs);
+                                    std::cout << cout_buffer;
+                                    glfwSetClipboardString(glfw.win, cout_buffer.c_str());
+                                    cout_buffer.clear();
+                                    */
                                 }
                             }
-                            if (nk_input_is_mouse_hovering_rect(&ctx->input, graph_bounds) &&
-                                (&ctx->input)->keyboard.keys[NK_KEY_COPY].down &&
-                                (&ctx->input)->keyboard.keys[NK_KEY_COPY].clicked) {
-                                /*
-                                cout_buffer = graphs_to_string(graphs);
-                                std::cout << cout_buffer;
-                                glfwSetClipboardString(glfw.win, cout_buffer.c_str());
-                                cout_buffer.clear();
-                                */
-                            }
                         }
                     }
                 }
@@ -1764,8 +2685,12 @@ int main(int argc, char *argv[]) {
         // Sleep(100);
     }
 
-    if (SerialPort.IsConnected())
+    if (devices.size())
         fmt::print("{}", "disconnecting...");
+    devices.clear();
+    // the demo's spilled chunks close with its graphs, then the session directory is empty
+    local_stream.graphs.clear();
+    remove_spill_directory();
 
     nk_glfw3_shutdown();
     glfwTerminate();
@@ -4,7 +4,19 @@
 
 #define ARDUINO_WAIT_TIME 2000
 
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+#include <termios.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 //#include <format>
@@ -12,20 +24,60 @@
 #include <fmt/format.h>
 #include <string>
 #include <array>
+#include <atomic>
 #include <memory>
 #include <memory_resource>
 
+//Line errors the driver counted since the port was opened
+struct line_errors {
+	//the uart's receive fifo overflowed
+	uint32_t overruns = 0;
+	//the driver's input buffer overflowed
+	uint32_t buffer_overruns = 0;
+	uint32_t framing = 0;
+	uint32_t parity = 0;
+	uint32_t breaks = 0;
+};
+
+#ifdef _WIN32
 class Serial
 {
 private:
 	//Serial comm handler
 	HANDLE hSerial = nullptr;
-	//Connection status
-	bool connected = false;
+	//Connection status, cleared by whichever thread notices the device is gone
+	std::atomic<bool> connected = false;
 	//Get various information about the connection
     COMSTAT status = {};
 	//Keep track of last error
 	DWORD errors = 0;
+	//Running totals of the errors ClearCommError reported, it clears them on every call
+	std::atomic<uint32_t> overruns = 0;
+	std::atomic<uint32_t> buffer_overruns = 0;
+	std::atomic<uint32_t> framing = 0;
+	std::atomic<uint32_t> parity = 0;
+	std::atomic<uint32_t> breaks = 0;
+
+	void ClearErrors() {
+		if (!ClearCommError(this->hSerial, &this->errors, &this->status)) {
+			//The device was unplugged, the handle stays open until Disconnect
+			this->status = {};
+			this->connected = false;
+			return;
+		}
+		if (this->errors) {
+			if (this->errors & CE_OVERRUN)
+				this->overruns.fetch_add(1, std::memory_order_relaxed);
+			if (this->errors & CE_RXOVER)
+				this->buffer_overruns.fetch_add(1, std::memory_order_relaxed);
+			if (this->errors & CE_FRAME)
+				this->framing.fetch_add(1, std::memory_order_relaxed);
+			if (this->errors & CE_RXPARITY)
+				this->parity.fetch_add(1, std::memory_order_relaxed);
+			if (this->errors & CE_BREAK)
+				this->breaks.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
 
 public:
 	//Create a Serial Object in an unconnected state
@@ -41,14 +93,7 @@ public:
 	};
 	//Close the connection
 	~Serial() {
-		//Check if we are connected before trying to disconnect
-		if (this->connected)
-		{
-			//We're no longer connected
-			this->connected = false;
-			//Close the serial handler
-			CloseHandle(this->hSerial);
-		}
+		Disconnect();
 	}
 	//Read data in a buffer, if nbChar is greater than the
 	//maximum number of bytes available, it will return only the
@@ -61,7 +106,7 @@ public:
 		unsigned int toRead;
 
 		//Use the ClearCommError function to get status info on the Serial port
-		ClearCommError(this->hSerial, &this->errors, &this->status);
+		ClearErrors();
 
 		//Check if there is something to read
 		if (this->status.cbInQue > 0)
@@ -90,6 +135,19 @@ public:
 		return 0;
 
 	};
+	//Block for up to timeout_ms milliseconds until there is something to read,
+	//returns true if ReadData would return data.
+	bool WaitReadable(int timeout_ms) {
+		for (;;) {
+			ClearErrors();
+			if (this->status.cbInQue > 0)
+				return true;
+			if (timeout_ms <= 0)
+				return false;
+			Sleep(1);
+			timeout_ms--;
+		}
+	}
 	//Writes data from a buffer through the Serial connection
 	//return true on success.
 	bool WriteData(const char* buffer, unsigned int nbChar) {
@@ -99,7 +157,7 @@ public:
 		if (!WriteFile(this->hSerial, (void*)buffer, nbChar, &bytesSend, 0))
 		{
 			//In case it don't work get comm error and return false
-			ClearCommError(this->hSerial, &this->errors, &this->status);
+			ClearErrors();
 
 			return false;
 		}
@@ -113,9 +171,25 @@ public:
 		return this->connected;
 	};
 
+	//Errors counted since Connect, safe to call while another thread reads
+	line_errors LineErrors() const {
+		line_errors ret;
+		ret.overruns = this->overruns.load(std::memory_order_relaxed);
+		ret.buffer_overruns = this->buffer_overruns.load(std::memory_order_relaxed);
+		ret.framing = this->framing.load(std::memory_order_relaxed);
+		ret.parity = this->parity.load(std::memory_order_relaxed);
+		ret.breaks = this->breaks.load(std::memory_order_relaxed);
+		return ret;
+	}
+
 	int Connect(const char* portName, bool reset, uint32_t baud_rate) {
-		//We're not yet connected
-		this->connected = false;
+		//Drop any previous connection
+		Disconnect();
+		this->overruns = 0;
+		this->buffer_overruns = 0;
+		this->framing = 0;
+		this->parity = 0;
+		this->breaks = 0;
 
 		//Try to connect to the given port throuh CreateFile
 		this->hSerial = CreateFile(portName,
@@ -185,6 +259,12 @@ public:
 		return this->connected;
 	}
 
+	//The name the port Connect(portIndex) opens goes by
+	static bool PortPath(int portIndex, char (&path)[64]) {
+		*fmt::format_to_n(path, sizeof(path) - 1, std::string_view{ "\\\\.\\COM{}" }, portIndex).out = 0;
+		return true;
+	}
+
 	int Connect(int portIndex, bool reset, uint32_t baud_rate) {
 		char lpTargetPath[5000]; // buffer to store the path of the COMPORTS
 
@@ -213,11 +293,11 @@ public:
 	}
 
 	int Disconnect() {
-		if (this->connected)
+		//We're no longer connected
+		this->connected = false;
+		if (this->hSerial && this->hSerial != INVALID_HANDLE_VALUE)
 		{
-			//We're no longer connected
-			this->connected = false;
-			//Close the serial handler
+			//Close the serial handler, it's still open after a device went away
 			CloseHandle(this->hSerial);
 			this->hSerial = nullptr;
 			return true;
@@ -226,65 +306,300 @@ public:
 			return false;
 		}
 	}
+};
 
-	std::array<uint32_t, 8> ListAvailable() {
-		std::array<uint32_t, 8> ret;
-		for (size_t i = 0; i < ret.size(); i++)
-			ret[i] = 0;
+#else
+//termios backend, the port is opened non-blocking and an epoll instance
+//tells us when there's data waiting so we never spin on an empty queue
+class Serial
+{
+private:
+	//Serial comm handler
+	int fd = -1;
+	//epoll instance watching fd for input
+	int epfd = -1;
+	//Connection status, cleared by whichever thread notices the device is gone
+	std::atomic<bool> connected = false;
+	//Keep track of last error
+	int errors = 0;
+	//The driver's error counters when we connected, they count from when the port was first opened
+	struct serial_icounter_struct icount_base = {};
 
-		char lpTargetPath[5000]; // buffer to store the path of the COMPORTS
+	//The device hung up or went away, the descriptors stay open until Disconnect
+	void Lost(int error) {
+		this->errors = error;
+		this->connected = false;
+	}
 
-		char buffer[64];
-		std::pmr::monotonic_buffer_resource m(buffer, 64);
-		std::pmr::string str(&m);
-		str.reserve(64);
+	static speed_t BaudToSpeed(uint32_t baud_rate) {
+		switch (baud_rate) {
+		case 1200: return B1200;
+		case 2400: return B2400;
+		case 4800: return B4800;
+		case 9600: return B9600;
+		case 19200: return B19200;
+		case 38400: return B38400;
+		case 57600: return B57600;
+		case 115200: return B115200;
+		case 230400: return B230400;
+#ifdef B460800
+		case 460800: return B460800;
+		case 500000: return B500000;
+		case 576000: return B576000;
+		case 921600: return B921600;
+		case 1000000: return B1000000;
+		case 1152000: return B1152000;
+		case 1500000: return B1500000;
+		case 2000000: return B2000000;
+		case 2500000: return B2500000;
+		case 3000000: return B3000000;
+		case 3500000: return B3500000;
+		case 4000000: return B4000000;
+#endif
+		default: return B0;
+		}
+	}
 
-		for (int i = 0; i < 255; i++) // checking ports from COM0 to COM255
-		{
-			//std::string str = "COM" + std::to_string(i); // converting to COM0, COM1, COM2
-			str.clear();
-			fmt::format_to(std::back_inserter(str), std::string_view{ "COM{}" }, i);
-			DWORD test = QueryDosDevice(str.c_str(), lpTargetPath, 5000);
+public:
+	//Create a Serial Object in an unconnected state
+	Serial() noexcept {
+
+	}
+	//Initialize Serial communication with the given port
+	Serial(const char* portName) {
+		Connect(portName, true, 9600);
+	};
+	Serial(const char* portName, bool reset, uint32_t baud_rate) {
+		Connect(portName, reset, baud_rate);
+	};
+	Serial(const Serial&) = delete;
+	Serial& operator=(const Serial&) = delete;
+	//Close the connection
+	~Serial() {
+		Disconnect();
+	}
+	//Read data in a buffer, if nbChar is greater than the
+	//number of bytes queued, it will return only the bytes
+	//available. A single read() drains as much as fits, there's
+	//no need to query the queue depth first. Returns the number
+	//of bytes actually read, 0 if nothing was read.
+	int ReadData(char* buffer, unsigned int nbChar) {
+		if (!this->connected)
+			return 0;
+
+		ssize_t bytesRead = ::read(this->fd, buffer, nbChar);
+		if (bytesRead > 0)
+			return (int)bytesRead;
+
+		//With VMIN at 1 an empty queue is EAGAIN, end of file means the line hung up,
+		//EIO is a pseudo terminal whose other end closed and ENXIO a device that's gone
+		if (bytesRead == 0)
+			Lost(EIO);
+		else if (errno == EIO || errno == ENXIO)
+			Lost(errno);
+		else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			this->errors = errno;
+
+		//If nothing has been read, or that an error was detected return 0
+		return 0;
+	};
+	//Block for up to timeout_ms milliseconds until there is something to read,
+	//returns true if ReadData would return data.
+	bool WaitReadable(int timeout_ms) {
+		if (!this->connected)
+			return false;
+
+		struct epoll_event ev;
+		int n;
+		do {
+			n = epoll_wait(this->epfd, &ev, 1, timeout_ms);
+		} while (n < 0 && errno == EINTR);
 
-			// Test the return value and error if any
-			ret[i / (sizeof(uint32_t)*8)] |= (test != 0 ? 1 : 0) << (i % (sizeof(uint32_t)*8));
+		//Whatever is still queued can be read after a hangup, ReadData notices the end once it's drained
+		if (n > 0 && (ev.events & (EPOLLERR | EPOLLHUP)) && !(ev.events & EPOLLIN))
+			Lost(EIO);
+
+		return n > 0 && (ev.events & EPOLLIN);
+	}
+	//Writes data from a buffer through the Serial connection
+	//return true on success.
+	bool WriteData(const char* buffer, unsigned int nbChar) {
+		if (!this->connected)
+			return false;
+
+		while (nbChar) {
+			ssize_t bytesSend = ::write(this->fd, buffer, nbChar);
+			if (bytesSend < 0) {
+				if (errno == EINTR)
+					continue;
+				if (errno == EAGAIN || errno == EWOULDBLOCK) {
+					//the tx queue is full, wait for the driver to drain it
+					tcdrain(this->fd);
+					continue;
+				}
+				if (errno == EIO || errno == ENXIO)
+					Lost(errno);
+				else
+					this->errors = errno;
+				return false;
+			}
+			buffer += bytesSend;
+			nbChar -= (unsigned int)bytesSend;
 		}
 
-		return ret;
+		return true;
+	};
+
+	//Check if we are actually connected
+	bool IsConnected() {
+		//Simply return the connection status
+		return this->connected;
+	};
+
+	//The last error reported by the os (errno), 0 if none
+	int LastError() const noexcept {
+		return this->errors;
 	}
-	std::array<std::string, 256> List() {
-		std::array<std::string, 256> ret;
 
-		char lpTargetPath[5000]; // buffer to store the path of the COMPORTS
+	//Errors counted since Connect, safe to call while another thread reads.
+	//Drivers without TIOCGICOUNT (cdc-acm, pseudo terminals) always report none
+	line_errors LineErrors() const {
+		line_errors ret;
+		struct serial_icounter_struct icount = {};
+		if (this->fd < 0 || ioctl(this->fd, TIOCGICOUNT, &icount) != 0)
+			return ret;
+		ret.overruns = (uint32_t)(icount.overrun - this->icount_base.overrun);
+		ret.buffer_overruns = (uint32_t)(icount.buf_overrun - this->icount_base.buf_overrun);
+		ret.framing = (uint32_t)(icount.frame - this->icount_base.frame);
+		ret.parity = (uint32_t)(icount.parity - this->icount_base.parity);
+		ret.breaks = (uint32_t)(icount.brk - this->icount_base.brk);
+		return ret;
+	}
 
-		char buffer[64];
-		std::pmr::monotonic_buffer_resource m(buffer, 64);
-		std::pmr::string str(&m);
-		str.reserve(64);
+	int Connect(const char* portName, bool reset, uint32_t baud_rate) {
+		//Drop any previous connection
+		Disconnect();
 
-		for (int i = 0; i < 255; i++) // checking ports from COM0 to COM255
+		this->fd = ::open(portName, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+		if (this->fd < 0)
 		{
-			//std::string str = "COM" + std::to_string(i); // converting to COM0, COM1, COM2
-			str.clear();
-			fmt::format_to(std::back_inserter(str), std::string_view{ "COM{}" }, i);
-			DWORD test = QueryDosDevice(str.c_str(), lpTargetPath, 5000);
-
-			// Test the return value and error if any
-			if (test != 0) //QueryDosDevice returns zero if it didn't find an object
-			{
-				ret[i] = std::string{ lpTargetPath };//std::format("{}", lpTargetPath);
-				//std::cout << str << ": " << lpTargetPath << std::endl;
-			} else {
-				ret[i] = "";
+			this->errors = errno;
+			if (errno == ENOENT) {
+				printf("ERROR: Handle was not attached. Reason: %s not available.\n", portName);
 			}
-
-			if (::GetLastError() == ERROR_INSUFFICIENT_BUFFER)
+			else
 			{
+				printf("ERROR!!!");
 			}
+			return false;
 		}
 
-		return ret;
+		struct termios tty;
+		if (tcgetattr(this->fd, &tty) != 0)
+		{
+			printf("failed to get current serial parameters!");
+			this->errors = errno;
+			::close(this->fd);
+			this->fd = -1;
+			return false;
+		}
+
+		speed_t speed = BaudToSpeed(baud_rate);
+		if (speed == B0)
+		{
+			printf("ALERT: Unsupported baud rate %u", baud_rate);
+			::close(this->fd);
+			this->fd = -1;
+			return false;
+		}
+
+		//Raw 8N1, no flow control, reads never block. VMIN stays at 1 so an empty
+		//queue reads as EAGAIN on the non-blocking fd and 0 only means a hangup
+		cfmakeraw(&tty);
+		cfsetispeed(&tty, speed);
+		cfsetospeed(&tty, speed);
+		tty.c_cflag |= (CLOCAL | CREAD);
+		tty.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+		tty.c_cc[VMIN] = 1;
+		tty.c_cc[VTIME] = 0;
+		if (!reset)
+			tty.c_cflag &= ~HUPCL;
+
+		if (tcsetattr(this->fd, TCSANOW, &tty) != 0)
+		{
+			printf("ALERT: Could not set Serial Port parameters");
+			this->errors = errno;
+			::close(this->fd);
+			this->fd = -1;
+			return false;
+		}
+
+		this->epfd = epoll_create1(EPOLL_CLOEXEC);
+		struct epoll_event ev = {};
+		ev.events = EPOLLIN;
+		ev.data.fd = this->fd;
+		if (this->epfd < 0 || epoll_ctl(this->epfd, EPOLL_CTL_ADD, this->fd, &ev) != 0)
+		{
+			this->errors = errno;
+			Disconnect();
+			return false;
+		}
+
+		//If everything went fine we're connected
+		this->connected = true;
+		this->icount_base = {};
+		ioctl(this->fd, TIOCGICOUNT, &this->icount_base);
+
+		//Toggling DTR resets the arduino, pseudo terminals don't support this so ignore failures
+		int dtr = TIOCM_DTR;
+		ioctl(this->fd, reset ? TIOCMBIS : TIOCMBIC, &dtr);
+		//Flush any remaining characters in the buffers
+		tcflush(this->fd, TCIOFLUSH);
+		if (reset) {
+			//We wait 2s as the arduino board will be reseting
+			std::this_thread::sleep_for(std::chrono::milliseconds(ARDUINO_WAIT_TIME));
+		}
+
+		return this->connected;
+	}
+
+	//The port Connect(portIndex) opens, false (and path left empty) if there isn't one
+	static bool PortPath(int portIndex, char (&path)[64]) {
+		//arduinos enumerate as cdc-acm, usb-serial bridges as ttyUSB
+		for (std::string_view prefix : {std::string_view{ "/dev/ttyACM{}" }, std::string_view{ "/dev/ttyUSB{}" }}) {
+			*fmt::format_to_n(path, sizeof(path) - 1, fmt::runtime(prefix), portIndex).out = 0;
+			if (::access(path, F_OK) == 0)
+				return true;
+		}
+		path[0] = 0;
+		return false;
+	}
+
+	int Connect(int portIndex, bool reset, uint32_t baud_rate) {
+		char path[64];
+		return PortPath(portIndex, path) ? Connect(path, reset, baud_rate) : false;
+	}
+
+	int Disconnect() {
+		if (this->epfd >= 0)
+		{
+			::close(this->epfd);
+			this->epfd = -1;
+		}
+		//We're no longer connected
+		this->connected = false;
+		if (this->fd >= 0)
+		{
+			//Close the serial handler, it's still open after a hangup
+			::close(this->fd);
+			this->fd = -1;
+			return true;
+		}
+		else {
+			return false;
+		}
 	}
 };
+#endif
 
-#endif
\ No newline at end of file
+#endif
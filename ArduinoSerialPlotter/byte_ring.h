@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+
+namespace real {
+// lock-free single producer / single consumer ring of bytes
+// the producer only ever touches _head, the consumer only ever touches _tail, both sides may read the other's index
+// capacity is rounded up to a power of two so indices can run freely and be masked on access
+class spsc_byte_ring {
+  private:
+    std::unique_ptr<char[]> _data;
+    size_t _mask = 0;
+    // keep the indices on their own cache lines so producer and consumer don't false share
+    alignas(64) std::atomic<size_t> _head = 0;
+    alignas(64) std::atomic<size_t> _tail = 0;
+
+    static constexpr size_t round_up_pow2(size_t v) noexcept {
+        size_t r = 1;
+        while (r < v)
+            r <<= 1;
+        return r;
+    }
+
+  public:
+    explicit spsc_byte_ring(size_t capacity) : _mask(round_up_pow2(capacity ? capacity : 1) - 1) {
+        _data = std::make_unique<char[]>(_mask + 1);
+    }
+    spsc_byte_ring(const spsc_byte_ring &) = delete;
+    spsc_byte_ring &operator=(const spsc_byte_ring &) = delete;
+
+    [[nodiscard]] size_t capacity() const noexcept { return _mask + 1; }
+    // bytes written but not yet consumed, exact from either thread at the moment of the call
+    [[nodiscard]] size_t size() const noexcept {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+    // producer side
+    // the largest contiguous free region, fill it then commit_write what was used
+    [[nodiscard]] std::span<char> write_region() noexcept {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        const size_t tail = _tail.load(std::memory_order_acquire);
+        const size_t free_bytes = capacity() - (head - tail);
+        const size_t offset = head & _mask;
+        const size_t contiguous = capacity() - offset;
+        return {_data.get() + offset, free_bytes < contiguous ? free_bytes : contiguous};
+    }
+    void commit_write(size_t count) noexcept {
+        assert(count <= capacity() - size());
+        _head.store(_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+    // copies as much of [src, src+count) as fits, returns the number of bytes written
+    size_t write(const char *src, size_t count) noexcept {
+        size_t written = 0;
+        while (written < count) {
+            std::span<char> region = write_region();
+            if (region.empty())
+                break;
+            size_t n = (count - written) < region.size() ? (count - written) : region.size();
+            std::memcpy(region.data(), src + written, n);
+            commit_write(n);
+            written += n;
+        }
+        return written;
+    }
+
+    // consumer side
+    // the largest contiguous readable region, use it then commit_read what was consumed
+    [[nodiscard]] std::span<const char> read_region() const noexcept {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        const size_t head = _head.load(std::memory_order_acquire);
+        const size_t used = head - tail;
+        const size_t offset = tail & _mask;
+        const size_t contiguous = capacity() - offset;
+        return {_data.get() + offset, used < contiguous ? used : contiguous};
+    }
+    // the most recently written byte, 0 when there's nothing to read
+    [[nodiscard]] char back() const noexcept {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        const size_t head = _head.load(std::memory_order_acquire);
+        return head != tail ? _data[(head - 1) & _mask] : '\0';
+    }
+    void commit_read(size_t count) noexcept {
+        assert(count <= size());
+        _tail.store(_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+    // copies up to count bytes into dst, returns the number of bytes read
+    size_t read(char *dst, size_t count) noexcept {
+        size_t copied = 0;
+        while (copied < count) {
+            std::span<const char> region = read_region();
+            if (region.empty())
+                break;
+            size_t n = (count - copied) < region.size() ? (count - copied) : region.size();
+            std::memcpy(dst + copied, region.data(), n);
+            commit_read(n);
+            copied += n;
+        }
+        return copied;
+    }
+};
+} // namespace real
@@ -0,0 +1,401 @@
+#pragma once
+#include "SerialClass.h"
+#include "load_generator.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#endif
+
+// anything that can feed bytes into a stream, same calling convention as Serial
+class data_source {
+  public:
+    virtual ~data_source() = default;
+    // read up to nbChar bytes, returns the number of bytes read, 0 if nothing was available
+    virtual int ReadData(char *buffer, unsigned int nbChar) = 0;
+    // block for up to timeout_ms milliseconds until ReadData has something to return
+    virtual bool WaitReadable(int timeout_ms) = 0;
+    // write nbChar bytes from buffer, false if they couldn't all be written or the source is read only
+    virtual bool WriteData(const char * /*buffer*/, unsigned int /*nbChar*/) { return false; }
+    // false once the source is closed or exhausted
+    virtual bool IsConnected() = 0;
+    virtual int Disconnect() = 0;
+    // true if the source holds data until we read it (files, pipes, streams), a reader may then wait for room
+    // instead of dropping bytes, false for sources that lose data when not drained (serial ports, datagrams)
+    virtual bool Backpressure() const { return false; }
+    // errors the driver counted on the line, only serial ports have any
+    virtual line_errors LineErrors() const { return {}; }
+};
+
+class serial_source final : public data_source {
+  public:
+    Serial port;
+
+    int ReadData(char *buffer, unsigned int nbChar) override { return port.ReadData(buffer, nbChar); }
+    bool WaitReadable(int timeout_ms) override { return port.WaitReadable(timeout_ms); }
+    bool WriteData(const char *buffer, unsigned int nbChar) override { return port.WriteData(buffer, nbChar); }
+    bool IsConnected() override { return port.IsConnected(); }
+    int Disconnect() override { return port.Disconnect(); }
+    line_errors LineErrors() const override { return port.LineErrors(); }
+};
+
+#ifndef _WIN32
+// files, named pipes, stdin and stream sockets
+// regular files are read in large sequential chunks until eof, everything else waits on epoll
+class fd_source final : public data_source {
+  private:
+    int fd = -1;
+    int epfd = -1;
+    bool owned = true;
+    bool regular = false;
+    // a named pipe reads as eof until its first writer shows up, only the writer leaving ends the stream
+    bool fifo = false;
+    bool seen_data = false;
+    bool connected = false;
+
+  public:
+    fd_source() noexcept {}
+    fd_source(const fd_source &) = delete;
+    fd_source &operator=(const fd_source &) = delete;
+    ~fd_source() override { Disconnect(); }
+
+    // take over an already open descriptor, owned decides if Disconnect closes it (stdin shouldn't be)
+    bool Attach(int new_fd, bool take_ownership) {
+        Disconnect();
+        fd = new_fd;
+        owned = take_ownership;
+
+        struct stat st;
+        bool stat_ok = fstat(fd, &st) == 0;
+        regular = stat_ok && S_ISREG(st.st_mode);
+        fifo = stat_ok && S_ISFIFO(st.st_mode);
+        seen_data = false;
+        if (regular) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        } else {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            epfd = epoll_create1(EPOLL_CLOEXEC);
+            struct epoll_event ev = {};
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            if (epfd < 0 || epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                Disconnect();
+                return false;
+            }
+        }
+        connected = true;
+        return true;
+    }
+
+    // files and named pipes, a pipe is opened non-blocking so we don't hang waiting for a writer
+    bool Open(const char *path) {
+        int new_fd = ::open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (new_fd < 0) {
+            printf("ERROR: could not open %s\n", path);
+            return false;
+        }
+        return Attach(new_fd, true);
+    }
+
+    // tcp client to host:port, meant for loopback capture servers
+    bool Connect(const char *host, uint16_t port) {
+        int new_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (new_fd < 0)
+            return false;
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, host, &addr.sin_addr) != 1 ||
+            ::connect(new_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            printf("ERROR: could not connect to %s:%u\n", host, (unsigned)port);
+            ::close(new_fd);
+            return false;
+        }
+        return Attach(new_fd, true);
+    }
+
+    int ReadData(char *buffer, unsigned int nbChar) override {
+        if (!connected)
+            return 0;
+        ssize_t bytesRead = ::read(fd, buffer, nbChar);
+        if (bytesRead > 0) {
+            seen_data = true;
+            return (int)bytesRead;
+        }
+        // eof, the writer went away or the file is done
+        if ((bytesRead == 0 && (!fifo || seen_data)) ||
+            (bytesRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+            connected = false;
+        return 0;
+    }
+
+    bool WaitReadable(int timeout_ms) override {
+        if (!connected)
+            return false;
+        if (regular)
+            return true;
+        struct epoll_event ev;
+        int n;
+        do {
+            n = epoll_wait(epfd, &ev, 1, timeout_ms);
+        } while (n < 0 && errno == EINTR);
+        if (n > 0 && fifo && !seen_data && !(ev.events & EPOLLIN)) {
+            // nobody has opened the pipe for writing yet, it reports hangup until they do
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+            return false;
+        }
+        // a hangup still has to be read to see the eof
+        return n > 0;
+    }
+
+    bool IsConnected() override { return connected; }
+
+    int Disconnect() override {
+        if (epfd >= 0) {
+            ::close(epfd);
+            epfd = -1;
+        }
+        if (fd >= 0) {
+            if (owned)
+                ::close(fd);
+            fd = -1;
+        }
+        bool was_connected = connected;
+        connected = false;
+        return was_connected;
+    }
+
+    bool Backpressure() const override { return true; }
+};
+
+// datagrams on a local udp port, each wakeup pulls a batch with a single recvmmsg
+class udp_source final : public data_source {
+  private:
+    static constexpr size_t max_batch = 64;
+    static constexpr size_t max_datagram = 2048;
+
+    int fd = -1;
+    int epfd = -1;
+    bool connected = false;
+    // datagrams land here first so each one gets a full slot, then they're packed into the caller's buffer
+    std::unique_ptr<char[]> scratch = std::make_unique<char[]>(max_batch * max_datagram);
+
+  public:
+    udp_source() noexcept {}
+    udp_source(const udp_source &) = delete;
+    udp_source &operator=(const udp_source &) = delete;
+    ~udp_source() override { Disconnect(); }
+
+    bool Bind(const char *host, uint16_t port) {
+        Disconnect();
+        fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            return false;
+        int rcvbuf = 4 << 20;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, host, &addr.sin_addr) != 1 || ::bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            printf("ERROR: could not bind %s:%u\n", host, (unsigned)port);
+            Disconnect();
+            return false;
+        }
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epfd < 0 || epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            Disconnect();
+            return false;
+        }
+        connected = true;
+        return true;
+    }
+
+    int ReadData(char *buffer, unsigned int nbChar) override {
+        if (!connected)
+            return 0;
+        struct mmsghdr msgs[max_batch];
+        struct iovec iovs[max_batch];
+        // only ask for as many datagrams as could possibly fit
+        size_t batch = (nbChar + max_datagram - 1) / max_datagram;
+        batch = batch < max_batch ? (batch ? batch : 1) : max_batch;
+        for (size_t i = 0; i < batch; i++) {
+            iovs[i].iov_base = scratch.get() + (i * max_datagram);
+            iovs[i].iov_len = max_datagram;
+            msgs[i] = {};
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int received = recvmmsg(fd, msgs, (unsigned int)batch, MSG_DONTWAIT, nullptr);
+        if (received <= 0)
+            return 0;
+
+        unsigned int bytesRead = 0;
+        for (int i = 0; i < received; i++) {
+            unsigned int len = msgs[i].msg_len;
+            // a datagram that doesn't fit is cut short, framing downstream will resync
+            if (len > nbChar - bytesRead)
+                len = nbChar - bytesRead;
+            std::memcpy(buffer + bytesRead, scratch.get() + (i * max_datagram), len);
+            bytesRead += len;
+        }
+        return (int)bytesRead;
+    }
+
+    bool WaitReadable(int timeout_ms) override {
+        if (!connected)
+            return false;
+        struct epoll_event ev;
+        int n;
+        do {
+            n = epoll_wait(epfd, &ev, 1, timeout_ms);
+        } while (n < 0 && errno == EINTR);
+        return n > 0;
+    }
+
+    bool IsConnected() override { return connected; }
+
+    int Disconnect() override {
+        if (epfd >= 0) {
+            ::close(epfd);
+            epfd = -1;
+        }
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        bool was_connected = connected;
+        connected = false;
+        return was_connected;
+    }
+};
+
+// a load_generator together with the Serial reading its pty, so it can be opened like any other source
+class generator_source final : public data_source {
+  public:
+    load_generator generator;
+    serial_source serial;
+
+    generator_source() noexcept {}
+    generator_source(const generator_source &) = delete;
+    generator_source &operator=(const generator_source &) = delete;
+    ~generator_source() override { Disconnect(); }
+
+    bool Start(uint32_t baud_rate) {
+        if (!generator.open())
+            return false;
+        if (!serial.port.Connect(generator.slave_path.c_str(), false, baud_rate)) {
+            generator.close();
+            return false;
+        }
+        generator.start();
+        return true;
+    }
+
+    int ReadData(char *buffer, unsigned int nbChar) override { return serial.ReadData(buffer, nbChar); }
+    // goes down the pty like it would to a board, the generator reads it and throws it away
+    bool WriteData(const char *buffer, unsigned int nbChar) override { return serial.WriteData(buffer, nbChar); }
+    bool WaitReadable(int timeout_ms) override { return serial.WaitReadable(timeout_ms); }
+    bool IsConnected() override { return serial.IsConnected(); }
+    line_errors LineErrors() const override { return serial.LineErrors(); }
+    int Disconnect() override {
+        generator.close();
+        return serial.Disconnect();
+    }
+};
+#endif
+
+// opens a source from a short description
+//   file:<path>         a capture on disk, or a named pipe
+//   stdin               whatever is piped into us
+//   tcp:<host>:<port>   a stream socket
+//   udp:<host>:<port>   datagrams sent to a local port
+//   gen:<msgs/s>[:<graphs>[:<slots>]][:json|:binary]
+//                       synthetic messages written into a pseudo terminal
+//   anything else       a serial port path
+// returns nullptr on failure
+inline std::unique_ptr<data_source> open_source(std::string_view spec, uint32_t baud_rate) {
+#ifndef _WIN32
+    auto split_host_port = [](std::string_view rest, std::string &host, uint16_t &port) {
+        size_t colon = rest.rfind(':');
+        if (colon == std::string_view::npos)
+            return false;
+        host.assign(rest.substr(0, colon));
+        if (host.empty())
+            host = "127.0.0.1";
+        std::string_view port_text = rest.substr(colon + 1);
+        return std::from_chars(port_text.data(), port_text.data() + port_text.size(), port).ec == std::errc{};
+    };
+
+    if (spec.starts_with("file:")) {
+        std::unique_ptr<fd_source> source = std::make_unique<fd_source>();
+        std::string path{spec.substr(5)};
+        if (source->Open(path.c_str()))
+            return source;
+        return nullptr;
+    } else if (spec == "stdin" || spec == "-") {
+        std::unique_ptr<fd_source> source = std::make_unique<fd_source>();
+        if (source->Attach(STDIN_FILENO, false))
+            return source;
+        return nullptr;
+    } else if (spec.starts_with("tcp:")) {
+        std::string host;
+        uint16_t port = 0;
+        std::unique_ptr<fd_source> source = std::make_unique<fd_source>();
+        if (split_host_port(spec.substr(4), host, port) && source->Connect(host.c_str(), port))
+            return source;
+        return nullptr;
+    } else if (spec.starts_with("udp:")) {
+        std::string host;
+        uint16_t port = 0;
+        std::unique_ptr<udp_source> source = std::make_unique<udp_source>();
+        if (split_host_port(spec.substr(4), host, port) && source->Bind(host.c_str(), port))
+            return source;
+        return nullptr;
+    } else if (spec.starts_with("gen:")) {
+        std::unique_ptr<generator_source> source = std::make_unique<generator_source>();
+        size_t *fields[] = {&source->generator.messages_per_second, &source->generator.graphs,
+                            &source->generator.slots};
+        // up to three numbers in that order, then optionally the format, which has to be the last field:
+        // gen:1000:json:4 is rejected rather than read as 4 slots
+        std::string_view rest = spec.substr(4);
+        for (size_t f = 0; !rest.empty(); f++) {
+            size_t colon = rest.find(':');
+            std::string_view field = rest.substr(0, colon);
+            rest = colon == std::string_view::npos ? std::string_view{} : rest.substr(colon + 1);
+            if (field == "json" || field == "binary") {
+                if (!f || !rest.empty())
+                    return nullptr;
+                source->generator.format =
+                    field == "json" ? load_generator::wire_format::json : load_generator::wire_format::binary;
+                break;
+            }
+            if (f >= 3)
+                return nullptr;
+            const char *end = field.data() + field.size();
+            const std::from_chars_result parsed = std::from_chars(field.data(), end, *fields[f]);
+            if (parsed.ec != std::errc{} || parsed.ptr != end)
+                return nullptr;
+        }
+        if (source->Start(baud_rate))
+            return source;
+        return nullptr;
+    }
+#endif
+    std::unique_ptr<serial_source> source = std::make_unique<serial_source>();
+    std::string path{spec};
+    if (source->port.Connect(path.c_str(), false, baud_rate))
+        return source;
+    return nullptr;
+}
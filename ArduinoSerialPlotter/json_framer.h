@@ -0,0 +1,196 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JSON_FRAMER_SSE2 1
+#endif
+
+// finds complete top level {...} objects in a stream that arrives in pieces
+// it keeps brace depth and string/escape state between calls, so every byte is looked at once no matter how many
+// reads an object is split over, and a span only comes out once its closing brace is in
+// offsets are relative to the front of the caller's buffer, tell the framer when that moves with consumed()
+struct json_framer {
+    static constexpr size_t npos = ~size_t{0};
+
+    struct frame {
+        size_t begin;
+        size_t end;
+    };
+
+    // an object that grows past this is given up on, it most likely lost its closing brace
+    // plotter messages are a few kB, this is generous without stalling a stream for long
+    size_t max_object_bytes = 1 << 16;
+    // number of objects given up on
+    size_t oversized = 0;
+    // a lost closing brace or a corrupted quote would otherwise swallow every message after it until the object hits
+    // max_object_bytes, instead an open object is given up on as soon as a new plotter message ({"t": <number>)
+    // starts inside it, nested objects never look like that (a graph's "t" is a string)
+    bool restart_on_message = true;
+    // number of objects given up on because a message started inside them
+    size_t restarts = 0;
+
+    // everything before this has been looked at
+    size_t scanned = 0;
+    // where the open object starts, npos between objects
+    size_t object_begin = npos;
+    uint32_t depth = 0;
+    bool in_string = false;
+    bool escaped = false;
+
+    void reset() noexcept {
+        scanned = 0;
+        object_begin = npos;
+        depth = 0;
+        in_string = false;
+        escaped = false;
+    }
+
+    // the caller dropped count bytes from the front of its buffer
+    void consumed(size_t count) noexcept {
+        scanned = scanned > count ? scanned - count : 0;
+        if (object_begin == npos)
+            return;
+        if (object_begin >= count) {
+            object_begin -= count;
+        } else {
+            // the open object was thrown away, look for a new one from here
+            object_begin = npos;
+            depth = 0;
+            in_string = false;
+            escaped = false;
+        }
+    }
+
+    // bytes at the front that can't be part of any object
+    [[nodiscard]] size_t garbage() const noexcept { return object_begin == npos ? scanned : object_begin; }
+
+    // looks for the next complete object in data[0, size), scanning only what wasn't seen before
+    bool next(const char *data, size_t size, frame &out) noexcept {
+        size_t i = scanned;
+        while (i < size) {
+            if (object_begin == npos) {
+                const char *lbrace = (const char *)std::memchr(data + i, '{', size - i);
+                if (!lbrace) {
+                    i = size;
+                    break;
+                }
+                i = lbrace - data;
+                object_begin = i++;
+                depth = 1;
+                in_string = false;
+                escaped = false;
+                continue;
+            }
+
+            if (escaped) {
+                escaped = false;
+                i++;
+            } else {
+                i = find_special(data, i, size, in_string);
+                if (i == size)
+                    break;
+                const char c = data[i++];
+                if (c == '{' && restart_on_message) {
+                    const int start = message_start(data, i - 1, size);
+                    if (start < 0) {
+                        // can't tell yet, look at this brace again once more has arrived
+                        i--;
+                        break;
+                    }
+                    if (start > 0) {
+                        restarts++;
+                        object_begin = i - 1;
+                        depth = 1;
+                        in_string = false;
+                        continue;
+                    }
+                }
+                if (in_string) {
+                    if (c == '\\')
+                        escaped = true;
+                    else if (c == '"')
+                        in_string = false;
+                } else if (c == '"') {
+                    in_string = true;
+                } else if (c == '{') {
+                    depth++;
+                } else if (c == '}' && --depth == 0) {
+                    out = {object_begin, i};
+                    object_begin = npos;
+                    scanned = i;
+                    return true;
+                }
+            }
+
+            if (i - object_begin > max_object_bytes) {
+                // start over one past the brace that opened it
+                oversized++;
+                i = object_begin + 1;
+                object_begin = npos;
+            }
+        }
+        scanned = i;
+        if (object_begin != npos && scanned - object_begin > max_object_bytes) {
+            oversized++;
+            scanned = object_begin + 1;
+            object_begin = npos;
+        }
+        return false;
+    }
+
+  private:
+    // 1 if data[at] opens what looks like a plotter message, 0 if it doesn't, -1 if more bytes are needed to tell
+    static int message_start(const char *data, size_t at, size_t size) noexcept {
+        size_t i = at + 1;
+        auto skip_whitespace = [&] {
+            while (i < size && (data[i] == ' ' || data[i] == '\n' || data[i] == '\r' || data[i] == '\t'))
+                i++;
+            return i < size;
+        };
+        if (!skip_whitespace())
+            return -1;
+        for (const char c : {'"', 't', '"'}) {
+            if (i == size)
+                return -1;
+            if (data[i++] != c)
+                return 0;
+        }
+        if (!skip_whitespace())
+            return -1;
+        if (data[i++] != ':')
+            return 0;
+        if (!skip_whitespace())
+            return -1;
+        return (data[i] >= '0' && data[i] <= '9') || data[i] == '-';
+    }
+
+    // index of the next byte that can change our state, size if there is none
+    // inside a string only quotes, backslashes and (for restart_on_message) opening braces matter, outside of one
+    // only quotes and braces
+    static size_t find_special(const char *data, size_t i, size_t size, bool in_string) noexcept {
+#if JSON_FRAMER_SSE2
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i open = _mm_set1_epi8('{');
+        const __m128i other = _mm_set1_epi8(in_string ? '\\' : '}');
+        for (; i + 16 <= size; i += 16) {
+            const __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+            const __m128i braces = _mm_or_si128(_mm_cmpeq_epi8(chunk, open), _mm_cmpeq_epi8(chunk, other));
+            const __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), braces);
+            const uint32_t mask = (uint32_t)_mm_movemask_epi8(hits);
+            if (mask)
+                return i + std::countr_zero(mask);
+        }
+#endif
+        for (; i < size; i++) {
+            const char c = data[i];
+            if (c == '"' || c == '{' || (in_string ? c == '\\' : c == '}'))
+                return i;
+        }
+        return size;
+    }
+};
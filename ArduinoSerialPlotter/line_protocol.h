@@ -0,0 +1,118 @@
+#pragma once
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LINE_PROTOCOL_SSE2 1
+#endif
+
+// the plain text lines most sketches print for the arduino ide's serial plotter
+//   Serial.print(a); Serial.print(','); Serial.println(b);        -> 1.5,2
+//   Serial.print("temp:"); Serial.print(t); Serial.print(' ');    -> temp:21.5 hum:40
+// fields are split on spaces, tabs and commas, a field can carry a label in front of a colon, and a line of nothing
+// but words names the series that follow
+
+// appends the offset of every '\n' in data[begin, size) to ends, 16 bytes at a time so short lines don't each pay
+// for a memchr call
+template <typename vector_type> void find_line_ends(const char *data, size_t begin, size_t size, vector_type &ends) {
+    size_t i = begin;
+#if LINE_PROTOCOL_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= size; i += 16) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+        for (uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)); mask; mask &= mask - 1)
+            ends.emplace_back(i + std::countr_zero(mask));
+    }
+#endif
+    for (; i < size; i++) {
+        if (data[i] == '\n')
+            ends.emplace_back(i);
+    }
+}
+
+struct plot_field {
+    // empty if the field had none
+    std::string_view label;
+    // the field as written when it isn't a number
+    std::string_view text;
+    float value = 0.0f;
+    bool number = false;
+};
+
+// splits one line (without its '\n') into fields, returns how many there were, only the first max_fields are kept
+inline size_t parse_plot_line(const char *first, const char *last, plot_field *fields, size_t max_fields) noexcept {
+    auto separator = [](char c) { return c == ' ' || c == ',' || c == '\t' || c == '\r'; };
+    size_t count = 0;
+    // "temp: 21.5", the label and its value ended up in separate fields
+    std::string_view pending_label;
+    while (first != last) {
+        while (first != last && separator(*first))
+            first++;
+        if (first == last)
+            break;
+        const char *begin = first;
+        while (first != last && !separator(*first))
+            first++;
+
+        plot_field field;
+        std::string_view number{begin, (size_t)(first - begin)};
+        const size_t colon = number.find(':');
+        if (colon != std::string_view::npos) {
+            field.label = number.substr(0, colon);
+            number = number.substr(colon + 1);
+            if (number.empty()) {
+                pending_label = field.label;
+                continue;
+            }
+        } else if (!pending_label.empty()) {
+            field.label = pending_label;
+        }
+        pending_label = {};
+
+        // from_chars doesn't take the '+' a few printf formats emit
+        const char *digits = number.data() + (number.size() > 1 && number[0] == '+');
+        const std::from_chars_result result = std::from_chars(digits, number.data() + number.size(), field.value);
+        field.number = result.ec == std::errc{} && result.ptr == number.data() + number.size();
+        if (!field.number)
+            field.text = {begin, (size_t)(first - begin)};
+        if (count < max_fields)
+            fields[count] = field;
+        count++;
+    }
+    return count;
+}
+
+enum class plot_lines_guess { no, undecided, yes };
+
+// whether data[0, size) reads as lines of numbers rather than json with some noise around it, undecided until two
+// complete lines with numbers are in, so the caller has to hold on to the text until then
+// whatever comes before the first newline may have been cut off so it isn't looked at, lines without a number (a
+// header naming the series, a boot message) don't count either way
+inline plot_lines_guess guess_plot_lines(const char *data, size_t size) noexcept {
+    constexpr size_t max_fields = 64;
+    plot_field fields[max_fields];
+    const char *end = data + size;
+    const char *line = (const char *)std::memchr(data, '\n', size);
+    size_t lines = 0;
+    while (line && lines < 4) {
+        const char *first = line + 1;
+        line = (const char *)std::memchr(first, '\n', end - first);
+        if (!line)
+            break;
+        const size_t count = parse_plot_line(first, line, fields, max_fields);
+        if (count > max_fields)
+            return plot_lines_guess::no;
+        size_t numbers = 0;
+        for (size_t f = 0; f < count; f++)
+            numbers += fields[f].number;
+        if (numbers && numbers != count)
+            return plot_lines_guess::no;
+        lines += numbers > 0;
+    }
+    return lines >= 2 ? plot_lines_guess::yes : plot_lines_guess::undecided;
+}
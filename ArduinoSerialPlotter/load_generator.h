@@ -0,0 +1,185 @@
+#pragma once
+#include "SerialClass.h"
+#include "plotter_binary.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fmt/format.h>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#ifndef _WIN32
+// writes synthetic arduino-plotter messages into a pseudo terminal at a fixed rate
+// the other end is an ordinary tty, so it exercises the same Serial -> handle_json -> render path a board would
+struct load_generator {
+    enum class wire_format { json, binary };
+
+    wire_format format = wire_format::json;
+    size_t messages_per_second = 1000;
+    size_t graphs = 4;
+    size_t slots = 3;
+    // the "pd" the messages announce
+    size_t history = 60;
+
+    // messages and bytes handed to the pty, and how often the pty was full because nobody was reading
+    std::atomic<uint64_t> messages_sent = 0;
+    std::atomic<uint64_t> bytes_sent = 0;
+    std::atomic<uint64_t> stalls = 0;
+    // bytes written to the device end, read off the pty and dropped so it never fills up
+    std::atomic<uint64_t> bytes_received = 0;
+
+    int master = -1;
+    std::string slave_path;
+    std::jthread thread;
+
+    load_generator() = default;
+    load_generator(const load_generator &) = delete;
+    load_generator &operator=(const load_generator &) = delete;
+    ~load_generator() { stop(); }
+
+    // opens the pty pair, slave_path is the end to connect a Serial to
+    bool open() {
+        master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+        if (master < 0)
+            return false;
+        if (grantpt(master) != 0 || unlockpt(master) != 0) {
+            ::close(master);
+            master = -1;
+            return false;
+        }
+        slave_path = ptsname(master);
+        // the line discipline must not echo or translate anything we write
+        struct termios tty;
+        if (tcgetattr(master, &tty) == 0) {
+            cfmakeraw(&tty);
+            tcsetattr(master, TCSANOW, &tty);
+        }
+        fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+        return true;
+    }
+
+    static constexpr std::string_view colors[] = {"green", "orange", "cyan", "yellow", "red", "blue", "pink", "purple"};
+
+    // a slow sine per slot, offset per graph so lines are easy to tell apart
+    static float sample(uint64_t sequence, size_t g, size_t s) noexcept {
+        return std::sin((float)sequence * 0.01f * (float)(s + 1) + (float)g) * (float)(s + 1);
+    }
+
+    void append_message(std::string &out, uint64_t timestamp_ms, uint64_t sequence) const {
+        if (format == wire_format::binary) {
+            append_packets(out, timestamp_ms, sequence);
+            return;
+        }
+        fmt::format_to(std::back_inserter(out), "{{\"t\":{},\"ng\":{},\"lu\":{},\"g\":[", timestamp_ms, graphs,
+                       sequence);
+        for (size_t g = 0; g < graphs; g++) {
+            fmt::format_to(std::back_inserter(out), "{}{{\"t\":\"graph #{}\",\"xvy\":0,\"pd\":{},\"sz\":{},\"l\":[",
+                           g ? "," : "", g, history, slots);
+            for (size_t s = 0; s < slots; s++)
+                fmt::format_to(std::back_inserter(out), "{}\"data #{}\"", s ? "," : "", s);
+            out.append("],\"c\":[");
+            for (size_t s = 0; s < slots; s++)
+                fmt::format_to(std::back_inserter(out), "{}\"{}\"", s ? "," : "",
+                               colors[s % (sizeof(colors) / sizeof(colors[0]))]);
+            out.append("],\"d\":[");
+            for (size_t s = 0; s < slots; s++)
+                fmt::format_to(std::back_inserter(out), "{}{}", s ? "," : "", sample(sequence, g, s));
+            out.append("]}");
+        }
+        out.append("]}\n");
+    }
+
+    // the same message as plotter_binary.h packets, a schema per graph once a second and a float samples packet
+    // per graph every time
+    void append_packets(std::string &out, uint64_t timestamp_ms, uint64_t sequence) const {
+        uint8_t frame[plotter_binary_max_frame];
+        const size_t count = slots < 255 ? slots : 255;
+        if (sequence % (messages_per_second ? messages_per_second : 1) == 0) {
+            char names[255][12];
+            const char *labels[255];
+            const char *color_names[255];
+            for (size_t s = 0; s < count; s++) {
+                *fmt::format_to_n(names[s], sizeof(names[s]) - 1, "data #{}", s).out = '\0';
+                labels[s] = names[s];
+                // the names are literals, so null terminated
+                color_names[s] = colors[s % (sizeof(colors) / sizeof(colors[0]))].data();
+            }
+            for (size_t g = 0; g < graphs && g < 256; g++) {
+                const std::string title = fmt::format("graph #{}", g);
+                const size_t length = plotter_binary_write_schema(frame, sizeof(frame), (uint8_t)g, title.c_str(),
+                                                                  (uint16_t)history, (uint8_t)count, labels,
+                                                                  color_names);
+                out.append((const char *)frame, length);
+            }
+        }
+        float values[255];
+        for (size_t g = 0; g < graphs && g < 256; g++) {
+            for (size_t s = 0; s < count; s++)
+                values[s] = sample(sequence, g, s);
+            const size_t length = plotter_binary_write_samples(frame, sizeof(frame), (uint8_t)g,
+                                                               (uint32_t)timestamp_ms, values, (uint8_t)count);
+            out.append((const char *)frame, length);
+        }
+    }
+
+    void start() {
+        stop();
+        thread = std::jthread([this](std::stop_token stop) {
+            std::string out;
+            out.reserve(1 << 16);
+            size_t pending = 0;
+            uint64_t sequence = 0;
+            const auto start = std::chrono::steady_clock::now();
+            char discard[256];
+            while (!stop.stop_requested()) {
+                for (ssize_t got; (got = ::read(master, discard, sizeof(discard))) > 0;)
+                    bytes_received.fetch_add(got, std::memory_order_relaxed);
+
+                const auto now = std::chrono::steady_clock::now();
+                const uint64_t elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+                const uint64_t due = (elapsed_ns * messages_per_second) / 1'000'000'000;
+
+                // only format more once what we have has been written
+                if (pending == out.size()) {
+                    out.clear();
+                    pending = 0;
+                    // cap the batch so a slow reader doesn't make us build megabytes
+                    for (size_t n = 0; sequence < due && n < 1024; n++, sequence++)
+                        append_message(out, elapsed_ns / 1'000'000, sequence);
+                    messages_sent.store(sequence, std::memory_order_relaxed);
+                }
+
+                if (pending < out.size()) {
+                    ssize_t written = ::write(master, out.data() + pending, out.size() - pending);
+                    if (written > 0) {
+                        pending += written;
+                        bytes_sent.fetch_add(written, std::memory_order_relaxed);
+                        continue;
+                    }
+                    stalls.fetch_add(1, std::memory_order_relaxed);
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+        });
+    }
+
+    void stop() {
+        if (thread.joinable()) {
+            thread.request_stop();
+            thread.join();
+        }
+    }
+
+    void close() {
+        stop();
+        if (master >= 0) {
+            ::close(master);
+            master = -1;
+        }
+    }
+};
+#endif
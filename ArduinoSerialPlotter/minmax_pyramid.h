@@ -0,0 +1,141 @@
+#pragma once
+#include "real_vector.h"
+#include <cstdint>
+#include <limits>
+#include <span>
+
+// the lowest and highest of some values, empty (lo > hi) until one is added
+template <typename T> struct basic_value_range {
+    T lo = std::numeric_limits<T>::infinity();
+    T hi = -std::numeric_limits<T>::infinity();
+
+    [[nodiscard]] bool empty() const noexcept { return lo > hi; }
+    // nan (a missing sample) compares false both ways so it never moves the bounds
+    void add(T v) noexcept {
+        lo = v < lo ? v : lo;
+        hi = v > hi ? v : hi;
+    }
+    void add(basic_value_range other) noexcept {
+        lo = other.lo < lo ? other.lo : lo;
+        hi = other.hi > hi ? other.hi : hi;
+    }
+};
+using value_range = basic_value_range<float>;
+
+// widens range to cover column, a plain loop over contiguous values the compiler can vectorize
+template <typename T> inline void column_extents(std::span<const T> column, basic_value_range<T> &range) noexcept {
+    T lo = range.lo;
+    T hi = range.hi;
+    for (const T v : column) {
+        lo = v < lo ? v : lo;
+        hi = v > hi ? v : hi;
+    }
+    range.lo = lo;
+    range.hi = hi;
+}
+
+// min/max over any range of a ring's storage without looking at every value in it
+// level 0 summarizes buckets of bucket_size slots and each level above pairs up the one below, so a query costs
+// O(log n) summaries plus the partial buckets at its two ends
+// writes are folded into their bucket as they come, a write to a bucket's first slot starts it over and the one to its
+// last slot passes it on to the levels above, the bucket a ring is partway through overwriting is the only one whose
+// summary is off and a query never covers it whole: the write head splits it into the newest and the oldest values
+template <typename T> class minmax_pyramid {
+  public:
+    static constexpr size_t bucket_size = 32;
+
+  private:
+    using range_type = basic_value_range<T>;
+
+    real::vector<real::vector<range_type>> _levels;
+    size_t _slots = 0;
+
+    void pass_up(size_t bucket) noexcept {
+        for (size_t level = 1; level < _levels.size(); level++) {
+            const real::vector<range_type> &below = _levels[level - 1];
+            bucket >>= 1;
+            range_type range = below[bucket * 2];
+            if (bucket * 2 + 1 < below.size())
+                range.add(below[bucket * 2 + 1]);
+            _levels[level][bucket] = range;
+        }
+    }
+
+  public:
+    // sized for a ring of slots values, nothing written yet
+    void reset(size_t slots) {
+        _slots = slots;
+        _levels.clear();
+        size_t count = (slots + bucket_size - 1) / bucket_size;
+        while (count) {
+            _levels.emplace_back();
+            _levels.back().assign(count, range_type{});
+            if (count == 1)
+                break;
+            count = (count + 1) / 2;
+        }
+    }
+
+    // summarizes storage from scratch, for when the values moved around or the ring changed size
+    void rebuild(std::span<const T> storage, size_t slots) {
+        reset(slots);
+        if (_levels.empty())
+            return;
+        for (size_t bucket = 0; bucket * bucket_size < storage.size(); bucket++) {
+            const size_t first = bucket * bucket_size;
+            const size_t count = storage.size() - first < bucket_size ? storage.size() - first : bucket_size;
+            column_extents(storage.subspan(first, count), _levels[0][bucket]);
+        }
+        for (size_t level = 1; level < _levels.size(); level++) {
+            for (size_t i = 0; i < _levels[level].size(); i++) {
+                range_type range = _levels[level - 1][i * 2];
+                if (i * 2 + 1 < _levels[level - 1].size())
+                    range.add(_levels[level - 1][i * 2 + 1]);
+                _levels[level][i] = range;
+            }
+        }
+    }
+
+    // v was just written to slot at
+    void write(size_t at, T v) noexcept {
+        const size_t bucket = at / bucket_size;
+        range_type &range = _levels[0][bucket];
+        if (at % bucket_size == 0)
+            range = range_type{};
+        range.add(v);
+        if ((at + 1) % bucket_size == 0 || at + 1 == _slots)
+            pass_up(bucket);
+    }
+
+    // slot at was written over again, its old value might still be in the summary so its bucket is redone
+    void rewrite(std::span<const T> storage, size_t at) noexcept {
+        const size_t bucket = at / bucket_size;
+        range_type range;
+        column_extents(storage.subspan(bucket * bucket_size, at % bucket_size + 1), range);
+        _levels[0][bucket] = range;
+        if ((at + 1) % bucket_size == 0 || at + 1 == _slots)
+            pass_up(bucket);
+    }
+
+    // min/max of storage[first, last), a range that doesn't have the write head inside it
+    [[nodiscard]] range_type query(std::span<const T> storage, size_t first, size_t last) const noexcept {
+        range_type range;
+        size_t lo = (first + bucket_size - 1) / bucket_size;
+        size_t hi = last / bucket_size;
+        if (lo >= hi) {
+            column_extents(storage.subspan(first, last - first), range);
+            return range;
+        }
+        column_extents(storage.subspan(first, lo * bucket_size - first), range);
+        column_extents(storage.subspan(hi * bucket_size, last - hi * bucket_size), range);
+        for (size_t level = 0; lo < hi; level++) {
+            if (lo & 1)
+                range.add(_levels[level][lo++]);
+            if (hi & 1)
+                range.add(_levels[level][--hi]);
+            lo >>= 1;
+            hi >>= 1;
+        }
+        return range;
+    }
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include "simdjson.h"
+
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <span>
+
+namespace real {
+// growable byte buffer that always keeps SIMDJSON_PADDING bytes of slack after its contents
+// producers write straight into the tail (prepare/commit) and the parser reads the contents in place
+// consuming from the front only moves a cursor, the contents are moved back to the start of the allocation only
+// when that frees at least as many bytes as it copies, so dropping data is O(1) however it's sliced up
+class padded_buffer {
+  private:
+    std::unique_ptr<char[]> _data;
+    // where the contents start in the allocation, everything before has been consumed
+    size_t _begin = 0;
+    size_t _size = 0;
+    // usable bytes, the allocation is always _capacity + SIMDJSON_PADDING
+    size_t _capacity = 0;
+
+    void grow(size_t required_capacity) {
+        size_t new_capacity = _capacity ? _capacity * 2 : 4096;
+        if (new_capacity < required_capacity)
+            new_capacity = required_capacity;
+        std::unique_ptr<char[]> new_data =
+            std::make_unique_for_overwrite<char[]>(new_capacity + simdjson::SIMDJSON_PADDING);
+        if (_size)
+            std::memcpy(new_data.get(), _data.get() + _begin, _size);
+        _data = std::move(new_data);
+        _begin = 0;
+        _capacity = new_capacity;
+    }
+
+    void compact() noexcept {
+        if (_size)
+            std::memmove(_data.get(), _data.get() + _begin, _size);
+        _begin = 0;
+    }
+
+  public:
+    padded_buffer() = default;
+    explicit padded_buffer(size_t capacity) { reserve(capacity); }
+
+    [[nodiscard]] char *data() noexcept { return _data.get() + _begin; }
+    [[nodiscard]] const char *data() const noexcept { return _data.get() + _begin; }
+    [[nodiscard]] size_t size() const noexcept { return _size; }
+    [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+    [[nodiscard]] size_t capacity() const noexcept { return _capacity; }
+    // bytes simdjson may touch past data() + offset
+    [[nodiscard]] size_t padded_capacity(size_t offset = 0) const noexcept {
+        return (_capacity + simdjson::SIMDJSON_PADDING) - _begin - offset;
+    }
+
+    void reserve(size_t capacity) {
+        if (capacity > _capacity)
+            grow(capacity);
+    }
+
+    // room for at least count bytes at the tail, write into it then commit() what was used
+    [[nodiscard]] std::span<char> prepare(size_t count) {
+        if (_capacity - _begin - _size < count) {
+            // sliding back is only worth it if it copies no more than was consumed
+            if (_begin >= _size && _size + count <= _capacity)
+                compact();
+            else
+                grow(_size + count);
+        }
+        return {_data.get() + _begin + _size, _capacity - _begin - _size};
+    }
+    void commit(size_t count) noexcept {
+        assert(count <= _capacity - _begin - _size);
+        _size += count;
+    }
+    void append(const char *src, size_t count) {
+        std::span<char> tail = prepare(count);
+        std::memcpy(tail.data(), src, count);
+        commit(count);
+    }
+
+    // drop count bytes from the front
+    void consume(size_t count) noexcept {
+        assert(count <= _size);
+        _size -= count;
+        // once empty we can start from the front again for free
+        _begin = _size ? _begin + count : 0;
+    }
+    void clear() noexcept {
+        _begin = 0;
+        _size = 0;
+    }
+
+    // view of the contents from offset on, the padding is already accounted for
+    [[nodiscard]] simdjson::padded_string_view view(size_t offset = 0) const noexcept {
+        return simdjson::padded_string_view(data() + offset, _size - offset, padded_capacity(offset));
+    }
+};
+} // namespace real
@@ -0,0 +1,234 @@
+#pragma once
+// compact binary alternative to the json messages, meant to be copied next to a sketch and emitted from the board
+// sticks to <stdint.h> and <string.h> so it builds with avr-gcc as well as on the desktop
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// wire format
+//   every packet is cobs encoded and ends in a single 0x00, so a reader that joins mid-stream (or loses bytes) is back
+//   in step at the next zero, and the 0x00 that json text never contains is what tells the two formats apart
+//   a decoded packet is [type u8][body][crc u16], the crc is crc-16/ccitt-false over type and body
+//   multi-byte fields are little endian, floats are ieee 754 binary32 (what avr, arm and x86 all use natively)
+//
+//   schema  [1][graph u8][limit u16][scale f32][slots u8][title][label, color] x slots
+//           text fields are [length u8][bytes], color is a name the plotter knows ("red", "green"...) or empty
+//           send it once at startup and every second or so after, a plotter connecting later picks it up from there
+//   samples [2][graph u8][timestamp ms u32][f32] x slots
+//           [3][graph u8][timestamp ms u32][i16] x slots, each multiplied by the schema's scale
+//           the slot count is implied by the length
+//
+// a graph with 3 float slots is 22 bytes on the wire per sample, the same graph as compact json is ~150
+enum plotter_binary_type : uint8_t {
+    plotter_binary_schema = 1,
+    plotter_binary_float_samples = 2,
+    plotter_binary_int16_samples = 3,
+};
+
+// longest packet (before encoding) the plotter accepts, with cobs overhead and the delimiter a frame is at most
+// plotter_binary_max_frame bytes
+static const size_t plotter_binary_max_packet = 1024;
+static const size_t plotter_binary_max_frame = plotter_binary_max_packet + plotter_binary_max_packet / 254 + 2;
+
+// crc-16/ccitt-false, bitwise so it costs no flash for a table
+inline uint16_t plotter_binary_crc(uint16_t crc, uint8_t byte) {
+    crc ^= (uint16_t)byte << 8;
+    for (uint8_t bit = 0; bit < 8; bit++)
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    return crc;
+}
+
+// builds one cobs frame in a caller supplied buffer, encoding as bytes are added so no second buffer is needed
+//   uint8_t frame[64];
+//   plotter_binary_writer out(frame, sizeof(frame));
+//   out.begin(plotter_binary_float_samples, 0);
+//   out.u32(millis());
+//   out.f32(temperature);
+//   Serial.write(frame, out.end());
+struct plotter_binary_writer {
+    uint8_t *out;
+    size_t capacity;
+    size_t size;
+    // where the length code of the current cobs block goes
+    size_t code_at;
+    uint8_t code;
+    uint16_t crc;
+    bool overflow;
+
+    plotter_binary_writer(uint8_t *buffer, size_t buffer_size)
+        : out(buffer), capacity(buffer_size), size(0), code_at(0), code(1), crc(0xFFFF), overflow(false) {}
+
+    void begin(uint8_t type, uint8_t graph) {
+        size = 1;
+        code_at = 0;
+        code = 1;
+        crc = 0xFFFF;
+        overflow = capacity < 2;
+        u8(type);
+        u8(graph);
+    }
+
+    // appends without touching the crc
+    void raw(uint8_t byte) {
+        if (size >= capacity) {
+            overflow = true;
+            return;
+        }
+        if (byte) {
+            out[size++] = byte;
+            code++;
+        }
+        if (!byte || code == 0xFF) {
+            // close the block, its code says how far away the next zero (or block) is
+            out[code_at] = code;
+            code_at = size++;
+            code = 1;
+        }
+    }
+
+    void u8(uint8_t v) {
+        crc = plotter_binary_crc(crc, v);
+        raw(v);
+    }
+    void u16(uint16_t v) {
+        u8((uint8_t)v);
+        u8((uint8_t)(v >> 8));
+    }
+    void i16(int16_t v) { u16((uint16_t)v); }
+    void u32(uint32_t v) {
+        u16((uint16_t)v);
+        u16((uint16_t)(v >> 16));
+    }
+    void f32(float v) {
+        uint32_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        u32(bits);
+    }
+    void text(const char *v) {
+        size_t length = v ? strlen(v) : 0;
+        length = length > 255 ? 255 : length;
+        u8((uint8_t)length);
+        for (size_t i = 0; i < length; i++)
+            u8((uint8_t)v[i]);
+    }
+
+    // adds the crc and the delimiter, returns the number of bytes to send or 0 if it didn't fit
+    size_t end() {
+        const uint16_t sum = crc;
+        raw((uint8_t)sum);
+        raw((uint8_t)(sum >> 8));
+        if (overflow || size >= capacity)
+            return 0;
+        out[code_at] = code;
+        out[size++] = 0;
+        return size;
+    }
+};
+
+// one call per message for the common cases, each returns the frame length or 0 if buffer is too small
+inline size_t plotter_binary_write_schema(uint8_t *buffer, size_t buffer_size, uint8_t graph, const char *title,
+                                          uint16_t limit, uint8_t slots, const char *const *labels,
+                                          const char *const *colors, float scale = 1.0f) {
+    plotter_binary_writer out(buffer, buffer_size);
+    out.begin(plotter_binary_schema, graph);
+    out.u16(limit);
+    out.f32(scale);
+    out.u8(slots);
+    out.text(title);
+    for (uint8_t s = 0; s < slots; s++) {
+        out.text(labels ? labels[s] : 0);
+        out.text(colors ? colors[s] : 0);
+    }
+    return out.end();
+}
+
+inline size_t plotter_binary_write_samples(uint8_t *buffer, size_t buffer_size, uint8_t graph, uint32_t timestamp_ms,
+                                           const float *values, uint8_t slots) {
+    plotter_binary_writer out(buffer, buffer_size);
+    out.begin(plotter_binary_float_samples, graph);
+    out.u32(timestamp_ms);
+    for (uint8_t s = 0; s < slots; s++)
+        out.f32(values[s]);
+    return out.end();
+}
+
+inline size_t plotter_binary_write_samples(uint8_t *buffer, size_t buffer_size, uint8_t graph, uint32_t timestamp_ms,
+                                           const int16_t *values, uint8_t slots) {
+    plotter_binary_writer out(buffer, buffer_size);
+    out.begin(plotter_binary_int16_samples, graph);
+    out.u32(timestamp_ms);
+    for (uint8_t s = 0; s < slots; s++)
+        out.i16(values[s]);
+    return out.end();
+}
+
+// undoes the cobs encoding of one frame (without its delimiter) into out, which needs size bytes
+// returns the decoded length, or 0 if the frame can't be valid cobs
+inline size_t plotter_binary_unframe(const uint8_t *frame, size_t size, uint8_t *out) {
+    size_t length = 0;
+    for (size_t i = 0; i < size;) {
+        const uint8_t code = frame[i++];
+        if (!code || i + code - 1 > size)
+            return 0;
+        for (uint8_t k = 1; k < code; k++) {
+            if (!frame[i])
+                return 0;
+            out[length++] = frame[i++];
+        }
+        // a short block stands for a zero, unless it's the last one
+        if (code != 0xFF && i < size)
+            out[length++] = 0;
+    }
+    return length;
+}
+
+// checks the crc of a decoded packet, true if it's intact
+inline bool plotter_binary_check(const uint8_t *packet, size_t size) {
+    if (size < 4)
+        return false;
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < size - 2; i++)
+        crc = plotter_binary_crc(crc, packet[i]);
+    return crc == (uint16_t)(packet[size - 2] | (packet[size - 1] << 8));
+}
+
+// reads fields back out of a decoded packet, a read past the end clears ok and returns 0
+struct plotter_binary_reader {
+    const uint8_t *at;
+    const uint8_t *end;
+    bool ok;
+
+    plotter_binary_reader(const uint8_t *packet, size_t size) : at(packet), end(packet + size), ok(true) {}
+
+    size_t remaining() const { return (size_t)(end - at); }
+    bool has(size_t count) {
+        ok = ok && remaining() >= count;
+        return ok;
+    }
+
+    uint8_t u8() { return has(1) ? *at++ : 0; }
+    uint16_t u16() {
+        const uint16_t low = u8();
+        return (uint16_t)(low | (u8() << 8));
+    }
+    int16_t i16() { return (int16_t)u16(); }
+    uint32_t u32() {
+        const uint32_t low = u16();
+        return low | ((uint32_t)u16() << 16);
+    }
+    float f32() {
+        const uint32_t bits = u32();
+        float v;
+        memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+    // points v at the bytes of a text field and returns its length
+    size_t text(const char *&v) {
+        const size_t length = u8();
+        v = (const char *)at;
+        if (!has(length))
+            return 0;
+        at += length;
+        return length;
+    }
+};
@@ -0,0 +1,202 @@
+#pragma once
+#include "real_vector.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// one serial port the system knows about
+struct serial_port {
+    // what Serial::Connect wants, eg. \\.\COM3 or /dev/ttyACM0
+    char path[24] = {};
+    // the short name inside path, COM3 or ttyACM0
+    uint8_t name_offset = 0;
+    // cdc-acm (and every COM port) sorts before usb-serial bridges
+    uint8_t kind = 0;
+    uint32_t number = 0;
+
+    [[nodiscard]] const char *name() const noexcept { return path + name_offset; }
+    [[nodiscard]] bool operator<(const serial_port &rhs) const noexcept {
+        return kind != rhs.kind ? kind < rhs.kind : number < rhs.number;
+    }
+    [[nodiscard]] bool operator==(const serial_port &rhs) const noexcept {
+        return kind == rhs.kind && number == rhs.number;
+    }
+};
+
+// the ports currently present, enumerated once and then kept up to date as devices come and go
+// poll() is cheap enough to call every frame, generation() changes whenever the list does
+class port_cache {
+  private:
+    real::vector<serial_port> _ports;
+    uint64_t _generation = 0;
+    bool _scanned = false;
+#ifdef _WIN32
+    // there's no change notification for dos devices without pulling in setupapi, rescan about once a second
+    size_t _last_scan_ms = 0;
+#else
+    int _inotify = -1;
+#endif
+
+    // recognizes a port name and fills in everything but the path
+    static bool parse_name(std::string_view name, serial_port &port) noexcept {
+#ifdef _WIN32
+        constexpr std::string_view prefixes[] = {"COM"};
+#else
+        constexpr std::string_view prefixes[] = {"ttyACM", "ttyUSB"};
+#endif
+        for (size_t k = 0; k < sizeof(prefixes) / sizeof(prefixes[0]); k++) {
+            if (!name.starts_with(prefixes[k]) || name.size() == prefixes[k].size())
+                continue;
+            const char *first = name.data() + prefixes[k].size();
+            const char *last = name.data() + name.size();
+            std::from_chars_result result = std::from_chars(first, last, port.number);
+            if (result.ec != std::errc{} || result.ptr != last)
+                return false;
+            port.kind = (uint8_t)k;
+            return true;
+        }
+        return false;
+    }
+
+    bool add(std::string_view name) {
+#ifdef _WIN32
+        constexpr std::string_view directory = "\\\\.\\";
+#else
+        constexpr std::string_view directory = "/dev/";
+#endif
+        serial_port port;
+        if (name.size() + directory.size() >= sizeof(port.path) || !parse_name(name, port))
+            return false;
+        std::memcpy(port.path, directory.data(), directory.size());
+        std::memcpy(port.path + directory.size(), name.data(), name.size());
+        port.name_offset = (uint8_t)directory.size();
+
+        auto it = std::lower_bound(_ports.begin(), _ports.end(), port);
+        if (it != _ports.end() && *it == port)
+            return false;
+        _ports.insert(it, port);
+        return true;
+    }
+
+    bool remove(std::string_view name) {
+        serial_port port;
+        if (!parse_name(name, port))
+            return false;
+        auto it = std::lower_bound(_ports.begin(), _ports.end(), port);
+        if (it == _ports.end() || !(*it == port))
+            return false;
+        _ports.erase(it);
+        return true;
+    }
+
+    void rescan() {
+        _ports.clear();
+#ifdef _WIN32
+        // one call lists every dos device name, double null terminated
+        real::vector<char> names(1 << 16, '\0');
+        DWORD length = 0;
+        while ((length = QueryDosDeviceA(nullptr, names.data(), (DWORD)names.size())) == 0 &&
+               ::GetLastError() == ERROR_INSUFFICIENT_BUFFER)
+            names.assign(names.size() * 2, '\0');
+        for (size_t offset = 0; offset < length && names[offset];) {
+            std::string_view name{names.data() + offset};
+            add(name);
+            offset += name.size() + 1;
+        }
+#else
+        // every tty the kernel registered, including ones udev hasn't made a node for yet
+        if (DIR *dir = opendir("/sys/class/tty")) {
+            while (struct dirent *entry = readdir(dir))
+                add(entry->d_name);
+            closedir(dir);
+        }
+#endif
+        _generation++;
+    }
+
+  public:
+    port_cache() = default;
+    port_cache(const port_cache &) = delete;
+    port_cache &operator=(const port_cache &) = delete;
+    ~port_cache() {
+#ifndef _WIN32
+        if (_inotify >= 0)
+            ::close(_inotify);
+#endif
+    }
+
+    [[nodiscard]] std::span<const serial_port> ports() const noexcept { return {_ports.data(), _ports.size()}; }
+    [[nodiscard]] uint64_t generation() const noexcept { return _generation; }
+
+    // picks up hotplug changes, the first call does the full enumeration, returns true if the list changed
+    bool poll() {
+        const uint64_t before = _generation;
+#ifdef _WIN32
+        const size_t now_ms = GetTickCount64();
+        if (!_scanned || (now_ms - _last_scan_ms) >= 1000) {
+            real::vector<serial_port> previous = _ports;
+            const uint64_t generation = _generation;
+            rescan();
+            // only a different list counts as a change
+            if (_scanned && previous.size() == _ports.size() &&
+                std::equal(previous.begin(), previous.end(), _ports.begin()))
+                _generation = generation;
+            _scanned = true;
+            _last_scan_ms = now_ms;
+        }
+#else
+        if (!_scanned) {
+            // watch before listing so nothing plugged in between the two is missed
+            _inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (_inotify >= 0 &&
+                inotify_add_watch(_inotify, "/dev", IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO) < 0) {
+                ::close(_inotify);
+                _inotify = -1;
+            }
+            rescan();
+            _scanned = true;
+            return true;
+        }
+        if (_inotify < 0)
+            return false;
+
+        alignas(struct inotify_event) char events[4096];
+        ssize_t length;
+        bool changed = false;
+        while ((length = ::read(_inotify, events, sizeof(events))) > 0) {
+            for (ssize_t offset = 0; offset < length;) {
+                const struct inotify_event *event = (const struct inotify_event *)(events + offset);
+                offset += sizeof(struct inotify_event) + event->len;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    // lost track, start over
+                    rescan();
+                    continue;
+                }
+                if (!event->len)
+                    continue;
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                    changed = add(event->name) || changed;
+                else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                    changed = remove(event->name) || changed;
+            }
+        }
+        if (changed)
+            _generation++;
+#endif
+        return _generation != before;
+    }
+};
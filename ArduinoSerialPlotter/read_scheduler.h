@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// picks how often the ui drains the serial reader
+// the cadence follows the observed arrival rate: slow streams are picked up as soon as a message is complete (or at
+// the latest after the latency target), fast streams are drained often enough that no more than batch_bytes pile up
+// between reads
+struct read_scheduler {
+    static constexpr size_t ns_per_second = 1'000'000'000;
+    static constexpr size_t ns_per_ms = 1'000'000;
+
+    // the longest we'll let a byte sit in the ring before it gets parsed
+    size_t latency_target_ns = 16 * ns_per_ms;
+    // how many bytes we'd like per read once the stream is fast enough to supply them
+    size_t batch_bytes = 4096;
+    // never read more often than this, the parser has fixed per-call overhead
+    size_t min_interval_ns = 1 * ns_per_ms;
+    // weight of the newest sample in the arrival rate average
+    double smoothing = 0.25;
+
+    // smoothed bytes per second
+    double arrival_rate = 0.0;
+    // the chosen cadence
+    size_t interval_ns = 16 * ns_per_ms;
+
+    size_t last_sample_ns = 0;
+    uint64_t last_total_bytes = 0;
+
+    // start over for a new connection, expected_bytes_per_second seeds the estimate (eg. baud / 10 for 8N1)
+    void reset(size_t expected_bytes_per_second, size_t now_ns, uint64_t total_bytes) noexcept {
+        arrival_rate = (double)expected_bytes_per_second;
+        last_sample_ns = now_ns;
+        last_total_bytes = total_bytes;
+        interval_ns = pick_interval();
+    }
+
+    // feed the reader's running byte count, returns the cadence to use from here on
+    size_t update(size_t now_ns, uint64_t total_bytes) noexcept {
+        const size_t elapsed = now_ns - last_sample_ns;
+        // sample over at least a few ms so a single burst doesn't dominate
+        if (elapsed >= 4 * ns_per_ms) {
+            const double rate = (double)(total_bytes - last_total_bytes) * (double)ns_per_second / (double)elapsed;
+            arrival_rate += (rate - arrival_rate) * smoothing;
+            last_sample_ns = now_ns;
+            last_total_bytes = total_bytes;
+            interval_ns = pick_interval();
+        }
+        return interval_ns;
+    }
+
+    // true when the stream is too slow to fill a batch within the latency target, waiting only adds lag then
+    [[nodiscard]] bool latency_bound() const noexcept { return interval_ns >= latency_target_ns; }
+
+    // whether the consumer should read now, a ring that's filling up is always drained immediately
+    // at_message_end says the newest byte closes a message, a slow stream doesn't sit on it for the rest of the interval
+    [[nodiscard]] bool due(size_t now_ns, size_t last_read_ns, size_t in_flight, size_t capacity,
+                           bool at_message_end = false) const noexcept {
+        return (now_ns - last_read_ns) >= interval_ns || in_flight >= (capacity / 2) ||
+               (at_message_end && in_flight && latency_bound());
+    }
+
+    // the last byte of a json object, a text line or a binary packet
+    [[nodiscard]] static bool ends_message(char c) noexcept { return c == '}' || c == '\n' || c == '\0'; }
+
+  private:
+    [[nodiscard]] size_t pick_interval() const noexcept {
+        size_t interval = latency_target_ns;
+        if (arrival_rate > 0.0) {
+            const double fill_ns = (double)batch_bytes * (double)ns_per_second / arrival_rate;
+            if (fill_ns < (double)interval)
+                interval = (size_t)fill_ns;
+        }
+        return interval < min_interval_ns ? min_interval_ns : interval;
+    }
+};
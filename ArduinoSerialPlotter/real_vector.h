@@ -219,7 +219,7 @@ template <typename T, typename Allocator = std::allocator<T>> class vector {
         const size_type old_size = size();
 
         if constexpr (::std::is_same<::std::random_access_iterator_tag,
-                                     ::std::iterator_traits<Iterator>::iterator_category>::value) {
+                                     typename ::std::iterator_traits<Iterator>::iterator_category>::value) {
             size_type insert_count = last - first;
             if (!can_store(insert_count)) {
                 size_t target_capacity = ExpansionPolicy{}.grow_capacity(old_size, _capacity_allocator.second(),
@@ -302,8 +302,12 @@ template <typename T, typename Allocator = std::allocator<T>> class vector {
     }
 
     constexpr vector(vector &&other) : _capacity_allocator(details::zero_then_variadic_args_t{}) {
-        if (!other.empty())
+        // take the storage even when it's empty, reserved capacity would leak otherwise
+        if (other._begin) {
             this->operator=(::std::move(other));
+            other._begin = other._end = nullptr;
+            other._capacity_allocator.second() = 0;
+        }
     }
 
     constexpr void set_vector(const pointer data, const size_type new_size, const size_type new_capacity) {
@@ -697,7 +701,7 @@ template <typename T, typename Allocator = std::allocator<T>> class vector {
 
     template <typename Iterator> constexpr void assign(Iterator first, Iterator last) {
         if constexpr (::std::is_same<::std::random_access_iterator_tag,
-                                     ::std::iterator_traits<Iterator>::iterator_category>::value) {
+                                     typename ::std::iterator_traits<Iterator>::iterator_category>::value) {
             size_type count = static_cast<size_type>(last - first);
             clear();
             if (count > capacity())
@@ -0,0 +1,244 @@
+#pragma once
+#include "minmax_pyramid.h"
+#include "real_vector.h"
+#include "series_ring.h"
+#include "spill_store.h"
+#include <cstdint>
+#include <limits>
+#include <span>
+
+// what a slot holds in a row it had no value for
+constexpr float missing_sample = std::numeric_limits<float>::quiet_NaN();
+template <typename T> [[nodiscard]] inline bool is_missing(T v) noexcept { return v != v; }
+
+// one column of a graph's samples, the newest rows in a ring with a min/max pyramid over it kept up to date
+// on every write, and when the ring is shorter than the column's limit the older rows in a spill_column (memory mapped
+// files) behind it, rows are counted oldest first across both
+// the extents of the whole column are tracked on their own: every new value widens them and they're only worked out
+// again (from the summaries) after the value sitting on one of the bounds was evicted, which for anything noisy is rare
+template <typename T> class basic_sample_column {
+  private:
+    real::series_ring<T> _ring;
+    minmax_pyramid<T> _lod;
+    spill_column<T> _cold;
+    // rows kept in the ring and the spill together
+    size_t _limit;
+    mutable basic_value_range<T> _window;
+    mutable bool _window_stale = false;
+
+    // a row is about to be pushed: the oldest row goes if the column is at its limit, and if the ring is full its
+    // oldest value (which the push writes over) moves to the spill when the column is longer than the ring
+    // if the row that went was holding up a bound the bounds have to be redone
+    void make_room() {
+        if (size() == _limit) {
+            // nan compares false, a missing value never holds a bound
+            const T evicted = _cold.empty() ? _ring.front() : _cold.pop_front();
+            _window_stale |= evicted <= _window.lo || evicted >= _window.hi;
+        }
+        if (_ring.full() && _ring.capacity() < _limit)
+            _cold.push_back(_ring.front());
+    }
+
+    // at least one row, and no more of them in ram than the column keeps
+    [[nodiscard]] static size_t clamp_limit(size_t limit) noexcept { return limit ? limit : 1; }
+    [[nodiscard]] static size_t clamp_hot(size_t limit, size_t hot) noexcept {
+        return hot ? (hot < limit ? hot : limit) : 1;
+    }
+
+  public:
+    explicit basic_sample_column(size_t limit, size_t hot)
+        : _ring(clamp_hot(clamp_limit(limit), hot)), _limit(clamp_limit(limit)) {
+        _lod.reset(_ring.capacity());
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return _cold.size() + _ring.size(); }
+    // rows in ram and rows spilled
+    [[nodiscard]] size_t hot_size() const noexcept { return _ring.size(); }
+    [[nodiscard]] size_t cold_size() const noexcept { return _cold.size(); }
+    [[nodiscard]] size_t cold_chunks() const noexcept { return _cold.chunks(); }
+    [[nodiscard]] T operator[](size_t i) const noexcept {
+        return i < _cold.size() ? _cold[i] : _ring[i - _cold.size()];
+    }
+    [[nodiscard]] T front() const noexcept { return _cold.empty() ? _ring.front() : _cold[0]; }
+    [[nodiscard]] T back() const noexcept { return _ring.back(); }
+
+    void push_back(T v) {
+        make_room();
+        _ring.push_back(v);
+        _lod.write(_ring.index_of(_ring.size() - 1), v);
+        _window.add(v);
+    }
+
+    // a row without a value (yet), cheaper than push_back(missing_sample) since it can't move the bounds
+    void push_missing() {
+        make_room();
+        _ring.push_back(std::numeric_limits<T>::quiet_NaN());
+        _lod.write(_ring.index_of(_ring.size() - 1), std::numeric_limits<T>::quiet_NaN());
+    }
+
+    // replaces the newest value, which is always in the ring
+    void set_back(T v) {
+        T &slot = _ring.back();
+        const bool was_missing = is_missing(slot);
+        slot = v;
+        const size_t at = _ring.index_of(_ring.size() - 1);
+        _window.add(v);
+        // a missing value never made it into the pyramid, anything else has to be taken out again
+        if (was_missing) {
+            _lod.write(at, v);
+        } else {
+            _lod.rewrite(_ring.storage(), at);
+            _window_stale = true;
+        }
+    }
+
+    // keeps the newest limit rows, at most hot of them in ram, a no-op if neither changes
+    // rows the ring no longer has room for are spilled, a bigger ring fills up with new rows while the spilled ones
+    // age out
+    void set_capacity(size_t limit, size_t hot) {
+        limit = clamp_limit(limit);
+        hot = clamp_hot(limit, hot);
+        if (limit == _limit && hot == _ring.capacity())
+            return;
+        _limit = limit;
+        while (size() > limit && !_cold.empty())
+            _cold.pop_front();
+        // the spill is older than anything in the ring, so whatever is still over the limit comes off the ring's
+        // front, and after that whatever doesn't fit in hot rows goes on the spill's back
+        const size_t drop = size() > limit ? size() - limit : 0;
+        const size_t spill = _ring.size() - drop > hot ? _ring.size() - drop - hot : 0;
+        _ring.unwrap();
+        const std::span<const T> rows = _ring.storage();
+        for (size_t i = drop; i < drop + spill; i++)
+            _cold.push_back(rows[i]);
+        _ring.set_capacity(hot);
+        _lod.rebuild(_ring.storage(), hot);
+        _window_stale = true;
+    }
+
+    void clear() {
+        _ring.clear();
+        _cold.clear();
+        _lod.reset(_ring.capacity());
+        _window = {};
+        _window_stale = false;
+    }
+
+    // min/max of every value in the column, O(1) unless a bound was evicted since the last call
+    [[nodiscard]] basic_value_range<T> extents() const noexcept {
+        if (_window_stale) {
+            _window = extents(0, size());
+            _window_stale = false;
+        }
+        return _window;
+    }
+
+    // min/max of the count values from the first-th oldest on, in O(log n) over the ring and per chunk and block of
+    // the spill
+    [[nodiscard]] basic_value_range<T> extents(size_t first, size_t count) const noexcept {
+        basic_value_range<T> range;
+        if (first < _cold.size()) {
+            const size_t cold = count < _cold.size() - first ? count : _cold.size() - first;
+            range = _cold.extents(first, cold);
+            first += cold;
+            count -= cold;
+        }
+        if (!count)
+            return range;
+        first -= _cold.size();
+        const std::span<const T> storage = _ring.storage();
+        const size_t begin = _ring.index_of(first);
+        const size_t end = begin + count;
+        if (end <= storage.size()) {
+            range.add(_lod.query(storage, begin, end));
+            return range;
+        }
+        // wraps around the end of the storage
+        range.add(_lod.query(storage, begin, storage.size()));
+        range.add(_lod.query(storage, 0, end - storage.size()));
+        return range;
+    }
+};
+
+// a slot's values
+using sample_column = basic_sample_column<float>;
+// a float runs out of whole milliseconds after about 4.6 hours, so timestamps get a double
+using timestamp_column = basic_sample_column<double>;
+
+// the samples of one graph, stored column by column
+// a row is one message: a timestamp all the slots share and a y for every slot, so the slots don't each carry a copy
+// of the timestamp and anything that goes over a slot (min/max, the transform to screen space) runs down a plain array
+// of floats
+// every column has one entry per row, a slot a message didn't have a value for holds missing_sample in that row
+// with a ram budget the columns only keep as many rows in memory as it pays for and spill the rest, so a long history
+// costs disk rather than ram
+struct sample_columns {
+    timestamp_column timestamps;
+    real::vector<sample_column> values;
+
+  private:
+    size_t _limit;
+    // bytes of samples kept in ram, 0 keeps every row in ram
+    size_t _ram_budget = 0;
+
+    // rows the budget pays for with a timestamp and slots values in each
+    [[nodiscard]] size_t hot_rows(size_t slots) const noexcept {
+        if (!_ram_budget)
+            return _limit;
+        const size_t rows = _ram_budget / (sizeof(double) + sizeof(float) * slots);
+        return rows < _limit ? rows : _limit;
+    }
+
+    void apply_capacity(size_t slots) {
+        const size_t hot = hot_rows(slots);
+        timestamps.set_capacity(_limit, hot);
+        for (size_t s = 0; s < values.size(); s++)
+            values[s].set_capacity(_limit, hot);
+    }
+
+  public:
+    explicit sample_columns(size_t capacity) : timestamps(capacity, capacity), _limit(capacity) {}
+
+    [[nodiscard]] size_t rows() const noexcept { return timestamps.size(); }
+    [[nodiscard]] size_t slots() const noexcept { return values.size(); }
+    [[nodiscard]] size_t ram_budget() const noexcept { return _ram_budget; }
+
+    // how many rows are kept, the newest ones survive a smaller capacity
+    void set_capacity(size_t capacity) {
+        _limit = capacity;
+        apply_capacity(values.size());
+    }
+
+    // bytes the columns may keep in ram between them, rows past that are spilled, 0 keeps them all in ram
+    void set_ram_budget(size_t bytes) {
+        if (bytes == _ram_budget)
+            return;
+        _ram_budget = bytes;
+        apply_capacity(values.size());
+    }
+
+    // adds a column, missing for every row so far, the budget is split one more way
+    void add_slot() {
+        apply_capacity(values.size() + 1);
+        values.emplace_back(_limit, hot_rows(values.size() + 1));
+        for (size_t r = 0; r < rows(); r++)
+            values.back().push_missing();
+    }
+
+    // starts a row with every slot missing, fill them in with set()
+    void push_row(double timestamp) {
+        timestamps.push_back(timestamp);
+        for (size_t s = 0; s < values.size(); s++)
+            values[s].push_missing();
+    }
+
+    // the value of slot in the newest row
+    void set(size_t slot, float v) { values[slot].set_back(v); }
+
+    // drops the rows and the columns
+    void clear() {
+        timestamps.clear();
+        values.clear();
+        apply_capacity(0);
+    }
+};
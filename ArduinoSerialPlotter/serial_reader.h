@@ -0,0 +1,77 @@
+#pragma once
+#include "byte_ring.h"
+#include "data_source.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// drains a data_source on its own thread into a lock-free ring so the os buffer never waits on the frame rate
+// whoever parses the stream is the only consumer of ring
+struct serial_reader {
+    real::spsc_byte_ring ring;
+
+    // total bytes pulled from the port
+    std::atomic<uint64_t> bytes_read = 0;
+    // number of reads that found the ring full, and the bytes thrown away because of it
+    std::atomic<uint64_t> overruns = 0;
+    std::atomic<uint64_t> overrun_bytes = 0;
+    // set when the thread ended because the source went away (hung up, unplugged, reached its end)
+    std::atomic<bool> source_lost = false;
+
+    std::jthread thread;
+
+    explicit serial_reader(size_t capacity = 1 << 20) : ring(capacity) {}
+    ~serial_reader() { stop(); }
+
+    // bytes read from the port that the consumer hasn't picked up yet
+    [[nodiscard]] size_t bytes_in_flight() const noexcept { return ring.size(); }
+
+    // the source must stay alive until stop() returns
+    void start(data_source &port) {
+        stop();
+        source_lost.store(false, std::memory_order_relaxed);
+        thread = std::jthread([this, &port](std::stop_token stop) {
+            char scratch[4096];
+            // readable but nothing came back, an error the source keeps reporting, don't spin on it
+            auto back_off = [] { std::this_thread::sleep_for(std::chrono::milliseconds(1)); };
+            while (!stop.stop_requested() && port.IsConnected()) {
+                if (!port.WaitReadable(10))
+                    continue;
+
+                std::span<char> region = ring.write_region();
+                if (region.empty() && port.Backpressure()) {
+                    // the source keeps its data until we come back for it, wait for the consumer
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                } else if (region.empty()) {
+                    // consumer fell behind, keep the os queue moving and account for what we lose
+                    int dropped = port.ReadData(scratch, sizeof(scratch));
+                    if (dropped > 0) {
+                        overruns.fetch_add(1, std::memory_order_relaxed);
+                        overrun_bytes.fetch_add(dropped, std::memory_order_relaxed);
+                    } else {
+                        back_off();
+                    }
+                    continue;
+                }
+
+                int read_count = port.ReadData(region.data(), (unsigned int)region.size());
+                if (read_count > 0) {
+                    ring.commit_write(read_count);
+                    bytes_read.fetch_add(read_count, std::memory_order_relaxed);
+                } else {
+                    back_off();
+                }
+            }
+            source_lost.store(!port.IsConnected(), std::memory_order_relaxed);
+        });
+    }
+
+    void stop() {
+        if (thread.joinable()) {
+            thread.request_stop();
+            thread.join();
+        }
+    }
+};
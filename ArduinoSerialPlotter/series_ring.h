@@ -0,0 +1,109 @@
+#pragma once
+#include "real_vector.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <span>
+
+namespace real {
+// the newest capacity() samples of a series
+// a push onto a full ring overwrites the oldest sample in place, so appending is O(1) however long the history is
+// (dropping the front of a vector moved every sample down one), oldest to newest the samples are the two contiguous
+// runs segments() returns
+template <typename T> class series_ring {
+  private:
+    real::vector<T> _data;
+    size_t _capacity = 0;
+    // where the oldest sample is once the ring has wrapped, 0 until then
+    size_t _head = 0;
+
+  public:
+    struct segments_type {
+        std::span<T> first;
+        std::span<T> second;
+    };
+    struct const_segments_type {
+        std::span<const T> first;
+        std::span<const T> second;
+    };
+
+    series_ring() = default;
+    explicit series_ring(size_t capacity) { set_capacity(capacity); }
+
+    [[nodiscard]] size_t size() const noexcept { return _data.size(); }
+    [[nodiscard]] size_t capacity() const noexcept { return _capacity; }
+    [[nodiscard]] bool empty() const noexcept { return _data.empty(); }
+    [[nodiscard]] bool full() const noexcept { return _data.size() == _capacity; }
+
+    // moves the samples around so they're oldest first in a single run
+    void unwrap() {
+        if (!_head)
+            return;
+        std::rotate(_data.begin(), _data.begin() + _head, _data.end());
+        _head = 0;
+    }
+
+    // keeps the newest min(size(), capacity) samples, a no-op if the capacity doesn't change, a smaller capacity
+    // gives the memory back
+    void set_capacity(size_t capacity) {
+        if (capacity == _capacity)
+            return;
+        // unwrap in place, then slide the newest down over whatever doesn't fit anymore
+        unwrap();
+        const size_t drop = size() > capacity ? size() - capacity : 0;
+        if (drop) {
+            std::move(_data.begin() + drop, _data.end(), _data.begin());
+            for (size_t i = 0; i < drop; i++)
+                _data.pop_back();
+        }
+        if (capacity < _data.capacity())
+            _data.unchecked_reserve(capacity);
+        else
+            _data.reserve(capacity);
+        _capacity = capacity;
+    }
+
+    void clear() noexcept {
+        _data.clear();
+        _head = 0;
+    }
+
+    // appends value, evicting the oldest sample when full, returns the new sample
+    T &push_back(const T &value) {
+        assert(_capacity);
+        if (_data.size() < _capacity)
+            return _data.emplace_back(value);
+        T &slot = _data[_head];
+        slot = value;
+        if (++_head == _capacity)
+            _head = 0;
+        return slot;
+    }
+
+    // where the i-th oldest sample sits in storage()
+    [[nodiscard]] size_t index_of(size_t i) const noexcept {
+        assert(i < size());
+        const size_t at = _head + i;
+        return at < _data.size() ? at : at - _data.size();
+    }
+    // i counts from the oldest sample
+    [[nodiscard]] T &operator[](size_t i) noexcept { return _data[index_of(i)]; }
+    [[nodiscard]] const T &operator[](size_t i) const noexcept { return _data[index_of(i)]; }
+
+    [[nodiscard]] T &front() noexcept { return _data[_head]; }
+    [[nodiscard]] const T &front() const noexcept { return _data[_head]; }
+    [[nodiscard]] T &back() noexcept { return _head ? _data[_head - 1] : _data.back(); }
+    [[nodiscard]] const T &back() const noexcept { return _head ? _data[_head - 1] : _data.back(); }
+
+    // the buffer the samples live in, a full ring overwrites it front to back over and over
+    [[nodiscard]] std::span<const T> storage() const noexcept { return {_data.data(), _data.size()}; }
+
+    // the samples oldest to newest as two contiguous runs, second is empty until the ring wraps
+    [[nodiscard]] segments_type segments() noexcept {
+        return {{_data.data() + _head, _data.size() - _head}, {_data.data(), _head}};
+    }
+    [[nodiscard]] const_segments_type segments() const noexcept {
+        return {{_data.data() + _head, _data.size() - _head}, {_data.data(), _head}};
+    }
+};
+} // namespace real
@@ -0,0 +1,238 @@
+#pragma once
+#include "minmax_pyramid.h"
+#include "real_vector.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <system_error>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// where the session directory goes, the system's temp directory if it's empty
+// spilled pages are only out of ram if this is on a disk, a tmpfs /tmp keeps them in memory (or swap) anyway
+// set it before anything spills
+inline std::filesystem::path spill_root;
+
+// the directory this process spills into, named after it so two plotters don't trip over each other
+inline const std::filesystem::path &spill_directory() {
+    static const std::filesystem::path directory = [] {
+        std::error_code ec;
+        std::filesystem::path path = spill_root.empty() ? std::filesystem::temp_directory_path(ec) : spill_root;
+#ifdef _WIN32
+        const unsigned long pid = GetCurrentProcessId();
+#else
+        const unsigned long pid = (unsigned long)getpid();
+#endif
+        path /= "ArduinoSerialPlotter-" + std::to_string(pid);
+        return path;
+    }();
+    return directory;
+}
+
+// best effort, the files in it are already gone once nothing maps them
+inline void remove_spill_directory() {
+    std::error_code ec;
+    std::filesystem::remove(spill_directory(), ec);
+}
+
+// a fixed number of values in a file of their own mapped into memory, with the min/max of every block of them
+// the file is deleted as soon as it's mapped (on windows when the mapping closes) so a crash doesn't leave it behind,
+// and if it can't be mapped at all the values live on the heap instead
+template <typename T> class spill_chunk {
+  public:
+    static constexpr size_t rows = 1 << 18;
+    static constexpr size_t block_rows = 256;
+
+    basic_value_range<T> whole;
+    std::array<basic_value_range<T>, rows / block_rows> blocks;
+
+  private:
+    T *_values = nullptr;
+    bool _mapped = false;
+#ifdef _WIN32
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#endif
+
+    static constexpr size_t bytes = rows * sizeof(T);
+
+    void map() noexcept {
+        std::error_code ec;
+        std::filesystem::create_directories(spill_directory(), ec);
+#ifdef _WIN32
+        wchar_t name[MAX_PATH];
+        if (!GetTempFileNameW(spill_directory().c_str(), L"asp", 0, name))
+            return;
+        _file = CreateFileW(name, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) {
+            DeleteFileW(name);
+            return;
+        }
+        _mapping = CreateFileMappingW(_file, nullptr, PAGE_READWRITE, 0, (DWORD)bytes, nullptr);
+        if (_mapping)
+            _values = (T *)MapViewOfFile(_mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+#else
+        std::string path = (spill_directory() / "spill-XXXXXX").string();
+        const int fd = mkstemp(path.data());
+        if (fd < 0)
+            return;
+        unlink(path.c_str());
+        if (ftruncate(fd, (off_t)bytes) == 0) {
+            void *view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (view != MAP_FAILED)
+                _values = (T *)view;
+        }
+        // the mapping keeps the file alive
+        close(fd);
+#endif
+        _mapped = _values != nullptr;
+    }
+
+  public:
+    spill_chunk() {
+        map();
+        if (!_values)
+            _values = new T[rows];
+    }
+    spill_chunk(const spill_chunk &) = delete;
+    spill_chunk &operator=(const spill_chunk &) = delete;
+
+    ~spill_chunk() {
+        if (!_mapped) {
+            delete[] _values;
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(_values);
+        CloseHandle(_mapping);
+        CloseHandle(_file);
+#else
+        munmap(_values, bytes);
+#endif
+    }
+
+    [[nodiscard]] T *values() noexcept { return _values; }
+    [[nodiscard]] const T *values() const noexcept { return _values; }
+    [[nodiscard]] bool mapped() const noexcept { return _mapped; }
+
+    // takes the chunk's pages out of the process, the os writes them out and reads them back in if they're touched
+    void release_pages() noexcept {
+        if (!_mapped)
+            return;
+#ifdef _WIN32
+        // not locked, so this only trims them from the working set
+        VirtualUnlock(_values, bytes);
+#else
+        madvise(_values, bytes, MADV_DONTNEED);
+#endif
+    }
+};
+
+// the older part of a sample_column, oldest first in chunks of spill_chunk<T>::rows
+// values only ever go on the back and come off the front, and rows are counted from the first one ever pushed so a
+// chunk's rows keep their place in it: chunk summaries and block summaries are only used for a range that covers them
+// whole, which rules out the chunk the front is partway through and the block the back is partway through
+template <typename T> class spill_column {
+  private:
+    using chunk_type = spill_chunk<T>;
+
+    // _chunks[0] holds rows from _base * chunk_type::rows on, chunks before the front one are released
+    real::vector<std::unique_ptr<chunk_type>> _chunks;
+    size_t _base = 0;
+    size_t _first = 0;
+    size_t _end = 0;
+
+    [[nodiscard]] const chunk_type &chunk_of(size_t row) const noexcept {
+        return *_chunks[row / chunk_type::rows - _base];
+    }
+
+  public:
+    [[nodiscard]] size_t size() const noexcept { return _end - _first; }
+    [[nodiscard]] bool empty() const noexcept { return _end == _first; }
+    // how many chunks are open, each one chunk_type::rows values
+    [[nodiscard]] size_t chunks() const noexcept {
+        return (_end + chunk_type::rows - 1) / chunk_type::rows - _first / chunk_type::rows;
+    }
+
+    [[nodiscard]] T operator[](size_t i) const noexcept {
+        const size_t row = _first + i;
+        return chunk_of(row).values()[row % chunk_type::rows];
+    }
+
+    void push_back(T v) {
+        const size_t at = _end % chunk_type::rows;
+        if (!at)
+            _chunks.emplace_back(std::make_unique<chunk_type>());
+        chunk_type &chunk = *_chunks.back();
+        chunk.values()[at] = v;
+        chunk.blocks[at / chunk_type::block_rows].add(v);
+        chunk.whole.add(v);
+        _end++;
+        if (at + 1 == chunk_type::rows)
+            chunk.release_pages();
+    }
+
+    T pop_front() noexcept {
+        const T v = (*this)[0];
+        if (++_first % chunk_type::rows)
+            return v;
+        // that was the last row of the front chunk
+        const size_t released = _first / chunk_type::rows - _base;
+        _chunks[released - 1].reset();
+        // slide the open chunks down once the released ones are half the vector
+        if (released * 2 >= _chunks.size()) {
+            std::move(_chunks.begin() + released, _chunks.end(), _chunks.begin());
+            for (size_t i = 0; i < released; i++)
+                _chunks.pop_back();
+            _base += released;
+        }
+        return v;
+    }
+
+    void clear() noexcept {
+        _chunks.clear();
+        _base = _first = _end = 0;
+    }
+
+    // min/max of the count values from the first-th oldest on
+    [[nodiscard]] basic_value_range<T> extents(size_t first, size_t count) const noexcept {
+        basic_value_range<T> range;
+        size_t row = _first + first;
+        const size_t last = row + count;
+        while (row < last) {
+            const chunk_type &chunk = chunk_of(row);
+            const size_t at = row % chunk_type::rows;
+            const size_t chunk_end = row - at + chunk_type::rows;
+            const size_t stop = last < chunk_end ? last : chunk_end;
+            if (!at && stop == chunk_end) {
+                range.add(chunk.whole);
+                row = stop;
+                continue;
+            }
+            while (row < stop) {
+                const size_t offset = row % chunk_type::rows;
+                const size_t block_end = row - offset % chunk_type::block_rows + chunk_type::block_rows;
+                const size_t next = stop < block_end ? stop : block_end;
+                if (offset % chunk_type::block_rows == 0 && next == block_end)
+                    range.add(chunk.blocks[offset / chunk_type::block_rows]);
+                else
+                    column_extents(std::span<const T>{chunk.values() + offset, next - row}, range);
+                row = next;
+            }
+        }
+        return range;
+    }
+};
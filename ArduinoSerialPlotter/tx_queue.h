@@ -0,0 +1,194 @@
+#pragma once
+#include "data_source.h"
+#include "real_vector.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// commands for a device, written by their own thread so neither the ui nor the reader ever waits on the port
+// whatever is queued when the writer wakes up goes out in as few writes as possible
+struct tx_queue {
+    static constexpr size_t ns_per_second = 1'000'000'000;
+
+    struct command {
+        uint64_t id = 0;
+        size_t queued_ns = 0;
+        std::string payload;
+    };
+
+    // what happened to a command once the writer was done with it
+    struct completion {
+        uint64_t id = 0;
+        size_t bytes = 0;
+        // from send() until the last byte was handed to the driver
+        size_t latency_ns = 0;
+        bool ok = false;
+    };
+
+    // pacing, 0 sends as fast as the port takes it
+    // otherwise at most chunk_bytes go out at a time, spaced to average bytes_per_second, so a board with a small
+    // rx buffer (64 bytes on an uno) has time to drain it
+    std::atomic<size_t> bytes_per_second = 0;
+    std::atomic<size_t> chunk_bytes = 64;
+    // upper bound on how much is coalesced into one batch
+    size_t max_batch_bytes = 1 << 16;
+
+    // totals for the ui
+    std::atomic<uint64_t> commands_sent = 0;
+    std::atomic<uint64_t> bytes_sent = 0;
+    std::atomic<uint64_t> failures = 0;
+    std::atomic<size_t> last_latency_ns = 0;
+    std::atomic<size_t> max_latency_ns = 0;
+    // commands are written in order, every id up to this one is done
+    std::atomic<uint64_t> completed_id = 0;
+
+    std::mutex mutex;
+    std::condition_variable_any ready;
+    // guarded by mutex
+    real::vector<command> pending;
+    size_t pending_bytes = 0;
+    uint64_t next_id = 1;
+    // the most recent completions, oldest overwritten first, guarded by mutex
+    real::vector<completion> history;
+    static constexpr size_t history_size = 64;
+
+    std::jthread thread;
+
+    tx_queue() { history.assign(history_size, completion{}); }
+    tx_queue(const tx_queue &) = delete;
+    tx_queue &operator=(const tx_queue &) = delete;
+    ~tx_queue() { stop(); }
+
+    // queues payload and returns its id, never blocks on the port
+    uint64_t send(std::string_view payload) {
+        uint64_t id;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            id = next_id++;
+            command &cmd = pending.emplace_back();
+            cmd.id = id;
+            cmd.queued_ns = std::chrono::steady_clock::now().time_since_epoch().count();
+            cmd.payload.assign(payload);
+            pending_bytes += payload.size();
+        }
+        ready.notify_one();
+        return id;
+    }
+
+    [[nodiscard]] bool done(uint64_t id) const noexcept { return completed_id.load(std::memory_order_acquire) >= id; }
+
+    [[nodiscard]] size_t queued_bytes() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending_bytes;
+    }
+
+    // copies out the completion for id if it's still in the history
+    bool find(uint64_t id, completion &out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const completion &entry = history[id % history_size];
+        if (entry.id != id)
+            return false;
+        out = entry;
+        return true;
+    }
+
+    // the port must stay alive until stop() returns
+    void start(data_source &port) {
+        stop();
+        thread = std::jthread([this, &port](std::stop_token stop) {
+            real::vector<command> batch;
+            std::string out;
+            // when pacing allows the next chunk to go out
+            size_t next_write_ns = 0;
+
+            while (!stop.stop_requested()) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    if (!ready.wait(lock, stop, [this] { return pending.size() > 0; }))
+                        break;
+                    // take as many whole commands as fit in a batch, always at least one
+                    size_t take = 0;
+                    size_t take_bytes = 0;
+                    while (take < pending.size() &&
+                           (take == 0 || take_bytes + pending[take].payload.size() <= max_batch_bytes))
+                        take_bytes += pending[take++].payload.size();
+                    batch.clear();
+                    for (size_t i = 0; i < take; i++)
+                        batch.emplace_back(std::move(pending[i]));
+                    pending.erase(pending.begin(), pending.begin() + take);
+                    pending_bytes -= take_bytes;
+                }
+
+                out.clear();
+                for (size_t i = 0; i < batch.size(); i++)
+                    out.append(batch[i].payload);
+
+                // written in chunks so each command's completion is known as soon as its last byte is out
+                size_t written = 0;
+                size_t command_end = 0;
+                size_t c = 0;
+                bool ok = true;
+                while (c < batch.size()) {
+                    const size_t rate = bytes_per_second.load(std::memory_order_relaxed);
+                    size_t chunk = out.size() - written;
+                    if (rate && ok) {
+                        const size_t paced = chunk_bytes.load(std::memory_order_relaxed);
+                        chunk = chunk < paced ? chunk : (paced ? paced : 1);
+                        size_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+                        if (now < next_write_ns)
+                            std::this_thread::sleep_for(std::chrono::nanoseconds(next_write_ns - now));
+                        now = std::chrono::steady_clock::now().time_since_epoch().count();
+                        next_write_ns = (next_write_ns > now ? next_write_ns : now) + (chunk * ns_per_second) / rate;
+                    }
+                    if (chunk && ok)
+                        ok = port.WriteData(out.data() + written, (unsigned int)chunk);
+                    written += chunk;
+                    if (ok)
+                        bytes_sent.fetch_add(chunk, std::memory_order_relaxed);
+
+                    // retire every command whose bytes are all out (or that can't be sent anymore)
+                    const size_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+                    while (c < batch.size() && (!ok || command_end + batch[c].payload.size() <= written)) {
+                        command_end += batch[c].payload.size();
+                        complete(batch[c], now, ok);
+                        c++;
+                    }
+                }
+            }
+        });
+    }
+
+    void stop() {
+        if (thread.joinable()) {
+            thread.request_stop();
+            thread.join();
+        }
+    }
+
+  private:
+    void complete(const command &cmd, size_t now_ns, bool ok) {
+        const size_t latency = now_ns - cmd.queued_ns;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            completion &entry = history[cmd.id % history_size];
+            entry.id = cmd.id;
+            entry.bytes = cmd.payload.size();
+            entry.latency_ns = latency;
+            entry.ok = ok;
+        }
+        if (ok)
+            commands_sent.fetch_add(1, std::memory_order_relaxed);
+        else
+            failures.fetch_add(1, std::memory_order_relaxed);
+        last_latency_ns.store(latency, std::memory_order_relaxed);
+        if (latency > max_latency_ns.load(std::memory_order_relaxed))
+            max_latency_ns.store(latency, std::memory_order_relaxed);
+        completed_id.store(cmd.id, std::memory_order_release);
+    }
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// helpers for checking utf-8 as it streams in, a read can end anywhere including halfway through a code point
+
+// how many bytes of data[0, size) end on a code point boundary, a truncated sequence at the end is left out
+// so it can be checked once the rest of it arrives
+inline size_t utf8_complete_prefix(const char *data, size_t size) noexcept {
+    for (size_t k = 1; k <= 3 && k <= size; k++) {
+        const uint8_t byte = (uint8_t)data[size - k];
+        if ((byte & 0xC0) == 0x80)
+            continue;
+        // a lead byte, see if everything it announces is there
+        const size_t length = byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : byte >= 0xC0 ? 2 : 1;
+        return length > k && byte < 0xF8 ? size - k : size;
+    }
+    return size;
+}
+
+// replaces every byte that isn't part of a valid utf-8 sequence with '?', so a corrupted byte costs a character
+// instead of the object around it, returns the number of bytes replaced and adds the number of runs to regions
+inline size_t utf8_repair(char *data, size_t size, size_t &regions) noexcept {
+    size_t replaced = 0;
+    bool in_run = false;
+    for (size_t i = 0; i < size;) {
+        const uint8_t byte = (uint8_t)data[i];
+        size_t length = 0;
+        if (byte < 0x80) {
+            length = 1;
+        } else if (byte >= 0xC2 && byte <= 0xF4) {
+            length = byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : 2;
+            if (i + length > size) {
+                length = 0;
+            } else {
+                // the second byte has a narrower range for a few leads (overlongs, surrogates, past U+10FFFF)
+                const uint8_t second = (uint8_t)data[i + 1];
+                const uint8_t low = byte == 0xE0 ? 0xA0 : byte == 0xF0 ? 0x90 : 0x80;
+                const uint8_t high = byte == 0xED ? 0x9F : byte == 0xF4 ? 0x8F : 0xBF;
+                bool ok = second >= low && second <= high;
+                for (size_t c = 2; ok && c < length; c++)
+                    ok = ((uint8_t)data[i + c] & 0xC0) == 0x80;
+                length = ok ? length : 0;
+            }
+        }
+
+        if (length) {
+            in_run = false;
+            i += length;
+        } else {
+            regions += !in_run;
+            in_run = true;
+            data[i++] = '?';
+            replaced++;
+        }
+    }
+    return replaced;
+}